@@ -19,5 +19,7 @@ void main() {
     float w = fwidth(sd);
     float alpha = smoothstep(-w, w, sd);
 
-    frag_color = vec4(u_color.rgb, u_color.a * alpha);
+    // Premultiplied, like sprite.frag.
+    float a = u_color.a * alpha;
+    frag_color = vec4(u_color.rgb * a, a);
 }
@@ -1,19 +1,102 @@
 #version 330 core
 
+// Textures hold premultiplied alpha, color keyed at load (util::TextureAlpha);
+// output is premultiplied, blended with glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA).
+// Night masks are multiply factors and stay as authored.
+//
+// Permutations:
+// - SPRITE_ARRAY: samples a texture array layer (see sprite.vert)
+// - NIGHT_COMPOSITE: base, shadow and mask in one invocation; the result is
+//   blended with dual-source blending, glBlendFunc(GL_ONE, GL_SRC1_COLOR).
+//   Without SPRITE_ARRAY, HAS_SHADOW / HAS_MASK select the overlays; with it,
+//   overlays are picked per instance (layer -1 = none).
+// - ALPHA_TEST: cutout frames in the depth-tested opaque pass; coverage is
+//   binary, so fragments are kept or discarded and written unblended (and
+//   un-premultiplied, as the sample is forced opaque).
+
 in vec2 v_uv;
+#ifdef SPRITE_ARRAY
+flat in float v_layer;
+#ifdef NIGHT_COMPOSITE
+in vec2 v_shadow_uv;
+in vec2 v_mask_uv;
+flat in float v_shadow_layer;
+flat in float v_mask_layer;
+#endif
+#endif
+
+#ifdef NIGHT_COMPOSITE
+layout(location = 0, index = 0) out vec4 frag_color;
+layout(location = 0, index = 1) out vec4 frag_blend; // per-channel weight of the destination
+#else
 out vec4 frag_color;
+#endif
 
+#ifdef SPRITE_ARRAY
+uniform sampler2DArray u_texture;
+#else
 uniform sampler2D u_texture;
+uniform sampler2D u_shadow_texture;
+uniform sampler2D u_mask_texture;
+#endif
+
+#ifdef NIGHT_COMPOSITE
+// Overlay samples; a missing shadow is transparent and a missing mask white,
+// which leaves the composite unchanged (and folds away at compile time).
+vec4 shadow_sample() {
+#if defined(SPRITE_ARRAY)
+    if (v_shadow_layer >= 0.0) {
+        return texture(u_texture, vec3(v_shadow_uv, v_shadow_layer));
+    }
+#elif defined(HAS_SHADOW)
+    return texture(u_shadow_texture, v_uv);
+#endif
+    return vec4(0.0);
+}
+
+vec4 mask_sample() {
+#if defined(SPRITE_ARRAY)
+    if (v_mask_layer >= 0.0) {
+        return texture(u_texture, vec3(v_mask_uv, v_mask_layer));
+    }
+#elif defined(HAS_MASK)
+    return texture(u_mask_texture, v_uv);
+#endif
+    return vec4(1.0);
+}
+#endif
 
 void main() {
+#ifdef SPRITE_ARRAY
+    vec4 c = texture(u_texture, vec3(v_uv, v_layer));
+#else
     vec4 c = texture(u_texture, v_uv);
+#endif
 
-    // Treat near-black as transparent
-    float eps = 5.0 / 255.0;
-    
-    if(all(lessThan(c.rgb, vec3(eps)))) {
-        c.a = 0.0;
+#ifdef ALPHA_TEST
+    if (c.a < 0.5) {
+        discard;
     }
+    // Edge texels are filtered against transparent (black) neighbours;
+    // un-premultiply so the kept fragment is opaque at its true colour.
+    c.rgb /= c.a;
+    c.a = 1.0;
+#endif
 
+#ifndef NIGHT_COMPOSITE
     frag_color = c;
+#else
+    // Folds the multi-pass sequence into src + dst * weight:
+    //   base   (ONE, ONE_MINUS_SRC_ALPHA)
+    //   shadow (ONE, ONE_MINUS_SRC_ALPHA)
+    //   mask   (DST_COLOR, ZERO)
+    vec4 h = shadow_sample();
+    vec4 m = mask_sample();
+
+    vec4 src = h + c * (1.0 - h.a);
+    vec4 weight = vec4((1.0 - c.a) * (1.0 - h.a));
+
+    frag_color = src * m;
+    frag_blend = weight * m;
+#endif
 }
@@ -1,24 +1,139 @@
 #version 330 core
 
+// Permutations (see ShaderCache):
+// - SPRITE_ARRAY: the sheet lives in a texture array; i_frame.x is an array
+//   layer and u_pass selects the shadow/mask overlay layer.
+// - NIGHT_COMPOSITE (with SPRITE_ARRAY): all three layers are passed to the
+//   fragment shader at once (-1 = no overlay) and u_pass is unused.
+
 // Static quad vertex in [0..1] range
 layout(location = 0) in vec2 aPos;
 
 // Per-instance attributes
-layout(location = 1) in vec2 i_pos;   // pixels
-layout(location = 2) in vec2 i_size;  // pixels
-layout(location = 3) in vec4 i_uv;    // (u0, v0, u1, v1)
+layout(location = 1) in vec2 i_pos;    // pixels
+layout(location = 2) in vec2 i_size;   // pixels, 12.4 fixed point
+layout(location = 3) in uvec2 i_frame; // (frame index / array layer or sequence ID, flags)
 
 uniform mat4 u_proj;
 
+// Draw layer; with depth testing (SpriteRenderer::set_depth_sorting) each
+// layer owns a band of the depth range, higher layers nearer.
+uniform float u_layer;
+
+#ifdef SPRITE_ARRAY
+// One (u1, v1, shadow_layer, mask_layer) entry per array layer.
+uniform samplerBuffer u_layer_table;
+
+// 0 = base, 1 = shadow, 2 = mask
+uniform int u_pass;
+#else
+// One (u0, v0, u1, v1) rect per frame of the bound sheet.
+uniform samplerBuffer u_uv_table;
+#endif
+
+// One (x0, y0, x1, y1) rect per frame (array layer): the part of the cell
+// holding visible texels. The quad is shrunk to it, so transparent padding
+// is never rasterized; UVs and placement stay those of the full cell.
+uniform samplerBuffer u_trim_table;
+
+// Animated instances (FLAG_ANIMATED): i_frame.x is a sequence ID and the
+// upper 12 flag bits are the start phase as a fraction of one loop.
+uniform float u_time; // wrapped to a common multiple of every loop (SequenceTable::period)
+uniform usamplerBuffer u_frames;   // all sequences' frame lists, back to back
+uniform samplerBuffer u_sequences; // (first_frame, frame_count, seconds_per_frame, 0)
+
+const uint FLAG_FLIP_X = 1u;
+const uint FLAG_FLIP_Y = 2u;
+const uint FLAG_ANIMATED = 4u;
+
+uint resolve_frame() {
+    if ((i_frame.y & FLAG_ANIMATED) == 0u) {
+        return i_frame.x;
+    }
+
+    vec4 seq = texelFetch(u_sequences, int(i_frame.x));
+    int count = int(seq.y);
+    if (count <= 0) {
+        return 0u;
+    }
+    if (seq.z <= 0.0) {
+        return texelFetch(u_frames, int(seq.x)).r; // no duration: hold the first frame
+    }
+
+    float phase = float(i_frame.y >> 4u) / 4096.0;
+    float cycle = fract(u_time / (seq.z * seq.y) + phase);
+    int step = min(int(cycle * seq.y), count - 1);
+
+    return texelFetch(u_frames, int(seq.x) + step).r;
+}
+
 out vec2 v_uv;
+#ifdef SPRITE_ARRAY
+flat out float v_layer;
+#ifdef NIGHT_COMPOSITE
+out vec2 v_shadow_uv;
+out vec2 v_mask_uv;
+flat out float v_shadow_layer;
+flat out float v_mask_layer;
+#endif
+#endif
 
 void main() {
-    // Interpolate UV based on quad vertex position.
-    // aPos is 0..1, so this maps corners correctly.
-    v_uv = mix(i_uv.xy, i_uv.zw, aPos);
+    uint frame = resolve_frame();
+
+    // t: position in the cell being sampled; local: where it lands in the quad.
+    vec4 trim = texelFetch(u_trim_table, int(frame));
+    vec2 t = mix(trim.xy, trim.zw, aPos);
+    vec2 local = t;
+    if ((i_frame.y & FLAG_FLIP_X) != 0u) local.x = 1.0 - local.x;
+    if ((i_frame.y & FLAG_FLIP_Y) != 0u) local.y = 1.0 - local.y;
+
+#ifdef SPRITE_ARRAY
+    int layer = int(frame);
+
+#ifdef NIGHT_COMPOSITE
+    // Cells sit in the top-left of their layer; overlays may have their own extent.
+    vec4 e = texelFetch(u_layer_table, layer);
+    v_shadow_layer = e.z;
+    v_mask_layer = e.w;
+    v_shadow_uv = e.z >= 0.0 ? texelFetch(u_layer_table, int(e.z)).xy * t : vec2(0.0);
+    v_mask_uv = e.w >= 0.0 ? texelFetch(u_layer_table, int(e.w)).xy * t : vec2(0.0);
+#else
+    if (u_pass != 0) {
+        vec4 e = texelFetch(u_layer_table, layer);
+        layer = int(u_pass == 1 ? e.z : e.w);
+    }
 
-    // Scale + translate the unit quad into world space
-    vec2 world = i_pos + aPos * i_size;
+    // Sheet has no overlay for this pass: emit a degenerate, clipped quad.
+    if (layer < 0) {
+        v_uv = vec2(0.0);
+        v_layer = 0.0;
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        return;
+    }
+#endif
+
+    vec2 extent = texelFetch(u_layer_table, layer).xy;
+
+    // Cells sit in the top-left of their layer.
+    v_uv = extent * t;
+    v_layer = float(layer);
+#else
+    vec4 uv = texelFetch(u_uv_table, int(frame));
+
+    // Interpolate UV based on the position in the cell.
+    v_uv = mix(uv.xy, uv.zw, t);
+#endif
+
+    // Scale + translate the (trimmed) unit quad into world space
+    vec2 world = i_pos + local * (i_size / 16.0);
 
     gl_Position = u_proj * vec4(world, 0.0, 1.0);
+
+    // Within the band, sprites whose feet (bottom edge) are lower on screen
+    // are nearer, matching the y-depth sort. Feet up to one viewport beyond
+    // either screen edge keep distinct depths.
+    float feet = (u_proj * vec4(0.0, i_pos.y + i_size.y / 16.0, 0.0, 1.0)).y * sign(u_proj[1][1]);
+    float band = clamp((3.0 - feet) / 6.0, 0.0, 0.999);
+    gl_Position.z = (255.0 - u_layer + band) / 128.0 - 1.0;
 }
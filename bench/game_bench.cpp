@@ -0,0 +1,323 @@
+// game_bench: CPU hot paths under Google Benchmark, no GL context needed
+// (GL is stubbed, see gl_stub.hpp). Run from the repository root so
+// assets/shaders and assets/fonts resolve.
+//
+// Cases take {sprites, sheets} so changes can be compared at several scales:
+//   game_bench --benchmark_filter=Submit
+//   game_bench --benchmark_format=json > before.json
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "bench/gl_stub.hpp"
+#include "renderer/sprite_renderer.hpp"
+#include "renderer/text_run_cache.hpp"
+#include "util/animation_library.hpp"
+#include "util/frame_stepper.hpp"
+#include "util/msdf_font.hpp"
+#include "util/sprite_sheet.hpp"
+
+namespace
+{
+    const std::vector<int64_t> sprite_counts = {1 << 10, 1 << 14, 1 << 17};
+    const std::vector<int64_t> sheet_counts = {1, 8, 64};
+
+    // Grid sheets backed by empty (stubbed) textures: 16x16 frames of 64px.
+    std::vector<std::unique_ptr<util::SpriteSheet>> make_sheets(int count)
+    {
+        std::vector<std::unique_ptr<util::SpriteSheet>> sheets;
+        for (int i = 0; i < count; ++i)
+        {
+            auto sheet = std::make_unique<util::SpriteSheet>();
+            auto &sprite = sheet->base_sprite();
+            sprite.texture.create(1024, 1024);
+            sprite.sprite_width = 64;
+            sprite.sprite_height = 64;
+            sheets.push_back(std::move(sheet));
+        }
+        return sheets;
+    }
+
+    renderer::SpriteRenderer &stub_renderer()
+    {
+        static renderer::SpriteRenderer *instance = []
+        {
+            if (!bench::load_gl_stub())
+            {
+                throw std::runtime_error("failed to load the GL stub");
+            }
+            return new renderer::SpriteRenderer(renderer::InstanceRing::Mode::Unsynchronized,
+                                                renderer::DrawBackend::Direct);
+        }();
+        return *instance;
+    }
+
+    // Sprites scattered over a 4096px square, round-robin over the sheets.
+    struct Scene
+    {
+        std::vector<std::unique_ptr<util::SpriteSheet>> sheets;
+        std::vector<util::SpriteSheet *> sprite_sheets;
+        std::vector<renderer::SpriteInstance> instances;
+
+        Scene(int sprites, int sheet_count)
+            : sheets(make_sheets(sheet_count))
+        {
+            std::mt19937 rng{1234};
+            std::uniform_real_distribution<float> pos(0.0f, 4096.0f);
+            std::uniform_int_distribution<unsigned int> frame(0, 255);
+
+            sprite_sheets.reserve(static_cast<size_t>(sprites));
+            instances.reserve(static_cast<size_t>(sprites));
+            for (int i = 0; i < sprites; ++i)
+            {
+                sprite_sheets.push_back(sheets[static_cast<size_t>(i % sheet_count)].get());
+                instances.push_back(renderer::SpriteInstance{
+                    .pos = {pos(rng), pos(rng)},
+                    .size = {32.0f, 32.0f},
+                    .frame_index = frame(rng),
+                });
+            }
+        }
+
+        // The stub renderer outlives every scene.
+        ~Scene()
+        {
+            for (const auto &sheet : sheets)
+            {
+                stub_renderer().unregister_sheet(*sheet);
+            }
+        }
+    };
+
+    void sprites_and_sheets(benchmark::internal::Benchmark *b)
+    {
+        b->ArgNames({"sprites", "sheets"})->ArgsProduct({sprite_counts, sheet_counts});
+    }
+}
+
+// SpriteSheet::uv_rect_vec4 over every sprite's frame.
+static void BM_UvRectVec4(benchmark::State &state)
+{
+    stub_renderer(); // GL stub for the sheet textures
+    const Scene scene(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)));
+
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < scene.instances.size(); ++i)
+        {
+            benchmark::DoNotOptimize(scene.sprite_sheets[i]->uv_rect_vec4(static_cast<int>(scene.instances[i].frame_index)));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_UvRectVec4)->Apply(sprites_and_sheets);
+
+// util::step_frame, the CPU animation path in main.cpp; one sequence per sheet.
+static void BM_StepFrame(benchmark::State &state)
+{
+    const auto sprites = static_cast<size_t>(state.range(0));
+    const auto sheets = static_cast<size_t>(state.range(1));
+
+    std::vector<float> accum(sprites, 0.0f);
+    std::vector<uint32_t> cursor(sprites, 0);
+    std::vector<float> seconds_per_frame(sprites);
+    std::vector<uint32_t> frame_count(sprites);
+    for (size_t i = 0; i < sprites; ++i)
+    {
+        seconds_per_frame[i] = 0.03f + 0.01f * static_cast<float>(i % sheets);
+        frame_count[i] = 8 + static_cast<uint32_t>(i % sheets);
+    }
+
+    const float dt = 1.0f / 60.0f;
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < sprites; ++i)
+        {
+            cursor[i] = util::step_frame(accum[i], cursor[i], dt, seconds_per_frame[i], frame_count[i]);
+        }
+        benchmark::DoNotOptimize(cursor.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_StepFrame)->Apply(sprites_and_sheets);
+
+// SpriteRenderer::submit: sort key and packed instance per sprite.
+static void BM_Submit(benchmark::State &state)
+{
+    auto &renderer = stub_renderer();
+    const Scene scene(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)));
+    const glm::mat4 proj{1.0f};
+
+    for (auto _ : state)
+    {
+        renderer.begin_batch(proj);
+        for (size_t i = 0; i < scene.instances.size(); ++i)
+        {
+            renderer.submit(scene.sprite_sheets[i], scene.instances[i]);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Submit)->Apply(sprites_and_sheets);
+
+// submit + end_batch: queue sort, run bucketing, ring gather and (stubbed) draws.
+static void BM_SubmitEndBatch(benchmark::State &state)
+{
+    auto &renderer = stub_renderer();
+    const Scene scene(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)));
+    const glm::mat4 proj{1.0f};
+
+    for (auto _ : state)
+    {
+        renderer.begin_batch(proj);
+        for (size_t i = 0; i < scene.instances.size(); ++i)
+        {
+            renderer.submit(scene.sprite_sheets[i], scene.instances[i]);
+        }
+        renderer.end_batch();
+        renderer.end_frame();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["draws"] = static_cast<double>(renderer.frame_stats().draw_calls);
+}
+BENCHMARK(BM_SubmitEndBatch)->Apply(sprites_and_sheets);
+
+// MsdfFont::render_text layout: `sprites` glyphs spread over `sheets` font instances.
+static void BM_RenderTextLayout(benchmark::State &state)
+{
+    auto &renderer = stub_renderer();
+
+    const auto glyphs = static_cast<size_t>(state.range(0));
+    const auto font_count = static_cast<size_t>(state.range(1));
+
+    std::vector<std::unique_ptr<util::MsdfFont>> fonts;
+    for (size_t i = 0; i < font_count; ++i)
+    {
+        auto font = std::make_unique<util::MsdfFont>();
+        if (!font->load("assets/fonts/font.json", "assets/fonts/font.png"))
+        {
+            state.SkipWithError("assets/fonts not found; run from the repository root");
+            return;
+        }
+        fonts.push_back(std::move(font));
+    }
+
+    // 64-character lines, like an overlay.
+    const std::string line = "FPS: 144  draws 37  instances 131072  upload 2048.0 KB  0123456";
+    const size_t lines = (glyphs + line.size() - 1) / line.size();
+    const glm::mat4 proj{1.0f};
+
+    for (auto _ : state)
+    {
+        renderer.begin_batch(proj, renderer::SpriteRenderer::BatchType::Font);
+        for (size_t i = 0; i < lines; ++i)
+        {
+            util::MsdfFont &font = *fonts[i % font_count];
+            font.render_text(renderer, line, 10.0f, 10.0f + 20.0f * static_cast<float>(i), 1.0f);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(lines * line.size()));
+
+    for (const auto &font : fonts)
+    {
+        renderer.unregister_sheet(font->sheet());
+    }
+}
+BENCHMARK(BM_RenderTextLayout)->Apply(sprites_and_sheets);
+
+// The same lines through TextRunCache: every iteration after the first is all hits.
+static void BM_TextRunCache(benchmark::State &state)
+{
+    auto &renderer = stub_renderer();
+
+    const auto glyphs = static_cast<size_t>(state.range(0));
+    const auto font_count = static_cast<size_t>(state.range(1));
+
+    std::vector<std::unique_ptr<util::MsdfFont>> fonts;
+    for (size_t i = 0; i < font_count; ++i)
+    {
+        auto font = std::make_unique<util::MsdfFont>();
+        if (!font->load("assets/fonts/font.json", "assets/fonts/font.png"))
+        {
+            state.SkipWithError("assets/fonts not found; run from the repository root");
+            return;
+        }
+        fonts.push_back(std::move(font));
+    }
+
+    const std::string line = "FPS: 144  draws 37  instances 131072  upload 2048.0 KB  0123456";
+    const size_t lines = (glyphs + line.size() - 1) / line.size();
+    const glm::mat4 proj{1.0f};
+    renderer::TextRunCache cache;
+
+    for (auto _ : state)
+    {
+        renderer.begin_batch(proj, renderer::SpriteRenderer::BatchType::Font);
+        for (size_t i = 0; i < lines; ++i)
+        {
+            cache.submit(renderer, *fonts[i % font_count], line, {10.0f, 10.0f + 20.0f * static_cast<float>(i)});
+        }
+        cache.end_frame();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(lines * line.size()));
+
+    for (const auto &font : fonts)
+    {
+        renderer.unregister_sheet(font->sheet());
+    }
+}
+BENCHMARK(BM_TextRunCache)->Apply(sprites_and_sheets);
+
+// load_animation_library over `files` synthetic JSON files of `frames` frames
+// per sequence (4 sequences each).
+static void BM_LoadAnimationLibrary(benchmark::State &state)
+{
+    namespace fs = std::filesystem;
+
+    const auto files = static_cast<int>(state.range(0));
+    const auto frames = static_cast<int>(state.range(1));
+
+    const fs::path dir = fs::temp_directory_path() /
+                         ("game_bench_animations_" + std::to_string(files) + "_" + std::to_string(frames));
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+
+    for (int f = 0; f < files; ++f)
+    {
+        std::ofstream out(dir / ("anim-" + std::to_string(f) + ".json"));
+        out << "{\"key\":\"anim-" << f << "\",\"assetFile\":\"assets/entity/anim-" << f << ".png\","
+            << "\"spriteCountX\":16,\"spriteCountY\":16,\"frameSequences\":{";
+        for (int s = 0; s < 4; ++s)
+        {
+            out << (s ? "," : "") << "\"seq" << s << "\":{\"secondsPerFrame\":0.05,\"frames\":[";
+            for (int i = 0; i < frames; ++i)
+            {
+                out << (i ? "," : "") << (s * frames + i) % 256;
+            }
+            out << "]}";
+        }
+        out << "}}";
+    }
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(util::load_animation_library(dir.string()));
+    }
+    state.SetItemsProcessed(state.iterations() * files);
+
+    fs::remove_all(dir);
+}
+BENCHMARK(BM_LoadAnimationLibrary)
+    ->ArgNames({"files", "frames"})
+    ->ArgsProduct({{256, 1024, 4096}, {8, 64}})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
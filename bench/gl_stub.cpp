@@ -0,0 +1,276 @@
+#include "gl_stub.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <glad/gl.h>
+
+namespace bench
+{
+    namespace
+    {
+        GLuint g_next_name = 1;
+        std::vector<unsigned char> g_map_scratch;
+
+        // Fallback for entry points the renderer never calls on this context
+        // (the rest of core 3.3), so gladLoadGL finds every pointer set.
+        // Calling it through another signature would be undefined: anything
+        // the renderer does call gets a typed stub below.
+        std::uintptr_t GLAD_API_PTR stub_noop()
+        {
+            return 0;
+        }
+
+        // Does nothing and returns a zero R, with the exact signature of the
+        // glad pointer type it is instantiated for.
+        template <typename Fn>
+        struct TypedNoop;
+
+        template <typename R, typename... Args>
+        struct TypedNoop<R(GLAD_API_PTR *)(Args...)>
+        {
+            static R GLAD_API_PTR call(Args...)
+            {
+                return R();
+            }
+        };
+
+        void GLAD_API_PTR stub_gen(GLsizei n, GLuint *names)
+        {
+            for (GLsizei i = 0; i < n; ++i)
+            {
+                names[i] = g_next_name++;
+            }
+        }
+
+        GLuint GLAD_API_PTR stub_create()
+        {
+            return g_next_name++;
+        }
+
+        GLuint GLAD_API_PTR stub_create_shader(GLenum)
+        {
+            return g_next_name++;
+        }
+
+        const GLubyte *GLAD_API_PTR stub_get_string(GLenum name)
+        {
+            return reinterpret_cast<const GLubyte *>(name == GL_VERSION ? "3.3.0 stub" : "stub");
+        }
+
+        const GLubyte *GLAD_API_PTR stub_get_stringi(GLenum, GLuint)
+        {
+            return reinterpret_cast<const GLubyte *>("");
+        }
+
+        void GLAD_API_PTR stub_get_integerv(GLenum pname, GLint *data)
+        {
+            switch (pname)
+            {
+            case GL_MAJOR_VERSION:
+            case GL_MINOR_VERSION:
+                *data = 3;
+                break;
+            case GL_MAX_TEXTURE_SIZE:
+                *data = 16384;
+                break;
+            case GL_MAX_ARRAY_TEXTURE_LAYERS:
+                *data = 2048;
+                break;
+            case GL_VIEWPORT:
+            case GL_SCISSOR_BOX:
+                std::memset(data, 0, 4 * sizeof(GLint));
+                break;
+            default:
+                *data = 0;
+                break;
+            }
+        }
+
+        void GLAD_API_PTR stub_get_shaderiv(GLuint, GLenum pname, GLint *params)
+        {
+            *params = (pname == GL_COMPILE_STATUS) ? GL_TRUE : 0;
+        }
+
+        void GLAD_API_PTR stub_get_programiv(GLuint, GLenum pname, GLint *params)
+        {
+            *params = (pname == GL_LINK_STATUS) ? GL_TRUE : 0;
+        }
+
+        void GLAD_API_PTR stub_get_info_log(GLuint, GLsizei size, GLsizei *length, GLchar *log)
+        {
+            if (length)
+            {
+                *length = 0;
+            }
+            if (log && size > 0)
+            {
+                log[0] = '\0';
+            }
+        }
+
+        GLint GLAD_API_PTR stub_get_uniform_location(GLuint, const GLchar *)
+        {
+            return -1;
+        }
+
+        void *GLAD_API_PTR stub_map_buffer_range(GLenum, GLintptr, GLsizeiptr length, GLbitfield)
+        {
+            if (g_map_scratch.size() < static_cast<std::size_t>(length))
+            {
+                g_map_scratch.resize(static_cast<std::size_t>(length));
+            }
+            return g_map_scratch.data();
+        }
+
+        GLboolean GLAD_API_PTR stub_unmap_buffer(GLenum)
+        {
+            return GL_TRUE;
+        }
+
+        GLsync GLAD_API_PTR stub_fence_sync(GLenum, GLbitfield)
+        {
+            return reinterpret_cast<GLsync>(std::uintptr_t{1});
+        }
+
+        GLenum GLAD_API_PTR stub_client_wait_sync(GLsync, GLbitfield, GLuint64)
+        {
+            return GL_ALREADY_SIGNALED;
+        }
+
+        GLenum GLAD_API_PTR stub_check_framebuffer_status(GLenum)
+        {
+            return GL_FRAMEBUFFER_COMPLETE;
+        }
+
+        void GLAD_API_PTR stub_get_query_objectuiv(GLuint, GLenum, GLuint *params)
+        {
+            *params = 0;
+        }
+
+        void GLAD_API_PTR stub_get_query_objectui64v(GLuint, GLenum, GLuint64 *params)
+        {
+            *params = 0;
+        }
+
+        struct Entry
+        {
+            const char *name;
+            GLADapiproc proc;
+        };
+
+        template <typename F>
+        GLADapiproc proc(F f)
+        {
+            return reinterpret_cast<GLADapiproc>(f);
+        }
+
+        // {"glFoo", typed no-op for glad's glFoo pointer type}
+#define STUB_NOOP(fn) {#fn, proc(TypedNoop<decltype(glad_##fn)>::call)}
+
+        GLADapiproc stub_loader(const char *name)
+        {
+            static const Entry entries[] = {
+                {"glGetString", proc(stub_get_string)},
+                {"glGetStringi", proc(stub_get_stringi)},
+                {"glGetIntegerv", proc(stub_get_integerv)},
+                {"glGenBuffers", proc(stub_gen)},
+                {"glGenTextures", proc(stub_gen)},
+                {"glGenVertexArrays", proc(stub_gen)},
+                {"glGenFramebuffers", proc(stub_gen)},
+                {"glGenRenderbuffers", proc(stub_gen)},
+                {"glGenQueries", proc(stub_gen)},
+                {"glCreateProgram", proc(stub_create)},
+                {"glCreateShader", proc(stub_create_shader)},
+                {"glGetShaderiv", proc(stub_get_shaderiv)},
+                {"glGetProgramiv", proc(stub_get_programiv)},
+                {"glGetShaderInfoLog", proc(stub_get_info_log)},
+                {"glGetProgramInfoLog", proc(stub_get_info_log)},
+                {"glGetUniformLocation", proc(stub_get_uniform_location)},
+                {"glMapBufferRange", proc(stub_map_buffer_range)},
+                {"glUnmapBuffer", proc(stub_unmap_buffer)},
+                {"glFenceSync", proc(stub_fence_sync)},
+                {"glClientWaitSync", proc(stub_client_wait_sync)},
+                {"glCheckFramebufferStatus", proc(stub_check_framebuffer_status)},
+                {"glGetQueryObjectuiv", proc(stub_get_query_objectuiv)},
+                {"glGetQueryObjectui64v", proc(stub_get_query_objectui64v)},
+
+                // Everything else the renderer, util and bench code calls.
+                STUB_NOOP(glActiveTexture),
+                STUB_NOOP(glAttachShader),
+                STUB_NOOP(glBeginQuery),
+                STUB_NOOP(glBindBuffer),
+                STUB_NOOP(glBindFramebuffer),
+                STUB_NOOP(glBindRenderbuffer),
+                STUB_NOOP(glBindTexture),
+                STUB_NOOP(glBindVertexArray),
+                STUB_NOOP(glBlendFunc),
+                STUB_NOOP(glBufferData),
+                STUB_NOOP(glBufferSubData),
+                STUB_NOOP(glClear),
+                STUB_NOOP(glClearColor),
+                STUB_NOOP(glCompileShader),
+                STUB_NOOP(glDeleteBuffers),
+                STUB_NOOP(glDeleteFramebuffers),
+                STUB_NOOP(glDeleteProgram),
+                STUB_NOOP(glDeleteQueries),
+                STUB_NOOP(glDeleteRenderbuffers),
+                STUB_NOOP(glDeleteShader),
+                STUB_NOOP(glDeleteSync),
+                STUB_NOOP(glDeleteTextures),
+                STUB_NOOP(glDeleteVertexArrays),
+                STUB_NOOP(glDepthFunc),
+                STUB_NOOP(glDepthMask),
+                STUB_NOOP(glDetachShader),
+                STUB_NOOP(glDisable),
+                STUB_NOOP(glDrawArraysInstanced),
+                STUB_NOOP(glEnable),
+                STUB_NOOP(glEnableVertexAttribArray),
+                STUB_NOOP(glEndQuery),
+                STUB_NOOP(glFinish),
+                STUB_NOOP(glFramebufferRenderbuffer),
+                STUB_NOOP(glFramebufferTexture2D),
+                STUB_NOOP(glGenerateMipmap),
+                STUB_NOOP(glGetActiveUniform),
+                STUB_NOOP(glGetTexImage),
+                STUB_NOOP(glLinkProgram),
+                STUB_NOOP(glPixelStorei),
+                STUB_NOOP(glRenderbufferStorage),
+                STUB_NOOP(glScissor),
+                STUB_NOOP(glShaderSource),
+                STUB_NOOP(glTexBuffer),
+                STUB_NOOP(glTexImage2D),
+                STUB_NOOP(glTexImage3D),
+                STUB_NOOP(glTexParameteri),
+                STUB_NOOP(glTexSubImage2D),
+                STUB_NOOP(glTexSubImage3D),
+                STUB_NOOP(glUniform1f),
+                STUB_NOOP(glUniform1i),
+                STUB_NOOP(glUniform4f),
+                STUB_NOOP(glUniformMatrix4fv),
+                STUB_NOOP(glUseProgram),
+                STUB_NOOP(glVertexAttribDivisor),
+                STUB_NOOP(glVertexAttribIPointer),
+                STUB_NOOP(glVertexAttribPointer),
+                STUB_NOOP(glViewport),
+            };
+
+            for (const Entry &entry : entries)
+            {
+                if (std::strcmp(entry.name, name) == 0)
+                {
+                    return entry.proc;
+                }
+            }
+            return proc(stub_noop);
+        }
+
+#undef STUB_NOOP
+    }
+
+    bool load_gl_stub()
+    {
+        return gladLoadGL(stub_loader) != 0;
+    }
+}
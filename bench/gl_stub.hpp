@@ -0,0 +1,14 @@
+#pragma once
+
+namespace bench
+{
+    // Points every glad entry point at a CPU-only stub so renderer code can run
+    // without a GL context. Object names are handed out sequentially, shaders
+    // compile and link, buffer maps return scratch memory and fences are always
+    // signalled; everything else does nothing and returns zero. Entry points
+    // the renderer calls are stubbed with their exact signatures.
+    //
+    // The context reports GL 3.3 with no extensions, so renderer fallbacks
+    // (InstanceRing::Mode::Unsynchronized, DrawBackend::Direct) are what runs.
+    bool load_gl_stub();
+}
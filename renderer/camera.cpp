@@ -0,0 +1,44 @@
+#include "camera.hpp"
+
+#include <algorithm>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace renderer
+{
+    void Camera::set_zoom_limits(float min_zoom, float max_zoom) noexcept
+    {
+        m_min_zoom = min_zoom;
+        m_max_zoom = max_zoom;
+        m_zoom = std::clamp(m_zoom, m_min_zoom, m_max_zoom);
+    }
+
+    void Camera::set_zoom(float zoom) noexcept
+    {
+        m_zoom = std::clamp(zoom, m_min_zoom, m_max_zoom);
+    }
+
+    void Camera::pan(glm::vec2 screen_delta) noexcept
+    {
+        m_position += screen_delta / m_zoom;
+    }
+
+    void Camera::zoom_at(float factor, glm::vec2 screen_point) noexcept
+    {
+        const glm::vec2 anchor = screen_to_world(screen_point);
+
+        m_zoom = std::clamp(m_zoom * factor, m_min_zoom, m_max_zoom);
+        m_position = anchor - screen_point / m_zoom;
+    }
+
+    glm::mat4 Camera::projection() const noexcept
+    {
+        const util::Aabb view = view_bounds();
+        return glm::ortho(view.min.x, view.max.x, view.max.y, view.min.y);
+    }
+
+    util::Aabb Camera::view_bounds() const noexcept
+    {
+        return {m_position, m_position + m_viewport / m_zoom};
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+
+#include "util/spatial_grid.hpp"
+
+namespace renderer
+{
+    // 2D pan/zoom camera for a y-down world.
+    // position() is the world point shown at the viewport's top-left corner;
+    // zoom() is screen pixels per world pixel.
+    class Camera
+    {
+    public:
+        void set_viewport(glm::vec2 size) noexcept { m_viewport = size; }
+        void set_position(glm::vec2 position) noexcept { m_position = position; }
+        void set_zoom_limits(float min_zoom, float max_zoom) noexcept;
+
+        // Clamped to the zoom limits; position() stays put.
+        void set_zoom(float zoom) noexcept;
+
+        // Moves the view by `screen_delta` screen pixels.
+        void pan(glm::vec2 screen_delta) noexcept;
+
+        // Scales zoom by `factor`, keeping the world point under `screen_point` fixed.
+        void zoom_at(float factor, glm::vec2 screen_point) noexcept;
+
+        glm::vec2 screen_to_world(glm::vec2 screen) const noexcept { return m_position + screen / m_zoom; }
+
+        glm::mat4 projection() const noexcept;
+
+        // World rect covered by the viewport.
+        util::Aabb view_bounds() const noexcept;
+
+        glm::vec2 position() const noexcept { return m_position; }
+        float zoom() const noexcept { return m_zoom; }
+
+    private:
+        glm::vec2 m_viewport{1.0f};
+        glm::vec2 m_position{0.0f};
+        float m_zoom = 1.0f;
+        float m_min_zoom = 0.05f;
+        float m_max_zoom = 8.0f;
+    };
+}
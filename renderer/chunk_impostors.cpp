@@ -0,0 +1,306 @@
+#include "chunk_impostors.hpp"
+
+#include <algorithm>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "util/profiler.hpp"
+
+namespace renderer
+{
+    ChunkImpostors::ChunkImpostors(const Settings &settings)
+        : m_settings(settings)
+    {
+    }
+
+    ChunkImpostors::~ChunkImpostors()
+    {
+        release();
+    }
+
+    int ChunkImpostors::slots_per_page() const noexcept
+    {
+        const int per_row = m_settings.page_size / m_settings.slot_size;
+        return per_row * per_row;
+    }
+
+    void ChunkImpostors::update(SpriteRenderer &renderer, const StaticSpriteLayer &layer, const util::Aabb &view, double now)
+    {
+        PROFILE_SCOPE("ChunkImpostors::update");
+
+        ++m_frame;
+
+        if (m_unsupported)
+        {
+            return;
+        }
+
+        if (m_chunk_slot.size() < layer.chunk_count())
+        {
+            m_chunk_slot.resize(layer.chunk_count(), -1);
+        }
+
+        if (std::find(m_renderers.begin(), m_renderers.end(), &renderer) == m_renderers.end())
+        {
+            m_renderers.push_back(&renderer);
+        }
+
+        m_visible.clear();
+        layer.visible_chunks(view, m_visible);
+
+        m_pending.clear();
+        for (const uint32_t chunk : m_visible)
+        {
+            const int slot = m_chunk_slot[chunk];
+            if (slot < 0)
+            {
+                m_pending.push_back({chunk, 0, 0.0});
+                continue;
+            }
+
+            Slot &s = m_slots[static_cast<size_t>(slot)];
+            s.last_used = m_frame;
+
+            if (s.version != layer.chunk_version(chunk))
+            {
+                m_pending.push_back({chunk, 1, s.rendered_at});
+            }
+            else if (now - s.rendered_at >= m_settings.refresh_interval)
+            {
+                m_pending.push_back({chunk, 2, s.rendered_at});
+            }
+        }
+
+        if (m_pending.empty())
+        {
+            return;
+        }
+
+        const std::size_t budget = std::min<std::size_t>(m_pending.size(), static_cast<std::size_t>(m_settings.renders_per_frame));
+        std::partial_sort(m_pending.begin(), m_pending.begin() + static_cast<std::ptrdiff_t>(budget), m_pending.end(),
+                          [](const Pending &a, const Pending &b)
+                          {
+                              return a.priority != b.priority ? a.priority < b.priority : a.rendered_at < b.rendered_at;
+                          });
+
+        GLint viewport[4] = {};
+        glGetIntegerv(GL_VIEWPORT, viewport);
+
+        // The frame may be going to an offscreen target (headless mode), not FBO 0.
+        GLint target = 0;
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target);
+
+        if (m_fbo == 0)
+        {
+            // Depth for SpriteRenderer::set_depth_sorting; pages only swap the
+            // colour attachment.
+            glGenRenderbuffers(1, &m_depth);
+            glBindRenderbuffer(GL_RENDERBUFFER, m_depth);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, m_settings.page_size, m_settings.page_size);
+            glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+            glGenFramebuffers(1, &m_fbo);
+            glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depth);
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+
+        for (std::size_t i = 0; i < budget; ++i)
+        {
+            const uint32_t chunk = m_pending[i].chunk;
+
+            int slot = m_chunk_slot[chunk];
+            if (slot < 0)
+            {
+                slot = acquire_slot();
+                if (slot < 0)
+                {
+                    break; // every slot is in view this frame; draw sprites instead
+                }
+                m_chunk_slot[chunk] = slot;
+            }
+
+            if (!render(renderer, layer, chunk, slot, now))
+            {
+                m_unsupported = true;
+                invalidate();
+                break;
+            }
+        }
+
+        glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(target));
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    }
+
+    int ChunkImpostors::acquire_slot()
+    {
+        // Free slot in an existing page.
+        for (std::size_t i = 0; i < m_slots.size(); ++i)
+        {
+            if (m_slots[i].chunk < 0)
+            {
+                return static_cast<int>(i);
+            }
+        }
+
+        // New page.
+        if (static_cast<int>(m_pages.size()) < m_settings.max_pages)
+        {
+            const int per_row = m_settings.page_size / m_settings.slot_size;
+            const float inv = 1.0f / static_cast<float>(m_settings.page_size);
+
+            // Frames are the slots, inset by one texel so linear filtering
+            // never reads a neighbour.
+            std::vector<glm::vec4> rects;
+            rects.reserve(static_cast<size_t>(slots_per_page()));
+            for (int index = 0; index < slots_per_page(); ++index)
+            {
+                const float x = static_cast<float>((index % per_row) * m_settings.slot_size);
+                const float y = static_cast<float>((index / per_row) * m_settings.slot_size);
+                const float edge = static_cast<float>(m_settings.slot_size);
+                rects.emplace_back((x + 1.0f) * inv, (y + 1.0f) * inv, (x + edge - 1.0f) * inv, (y + edge - 1.0f) * inv);
+            }
+
+            auto page = std::make_unique<util::SpriteSheet>();
+            auto &sprite = page->base_sprite();
+            sprite.texture.create(m_settings.page_size, m_settings.page_size);
+            sprite.texture.set_filtering(GL_LINEAR, GL_LINEAR);
+            sprite.sprite_width = m_settings.slot_size;
+            sprite.sprite_height = m_settings.slot_size;
+            page->set_uv_rects(rects);
+
+            m_pages.push_back(std::move(page));
+
+            const std::size_t first = m_slots.size();
+            m_slots.resize(first + static_cast<size_t>(slots_per_page()));
+            return static_cast<int>(first);
+        }
+
+        // Evict the least recently drawn slot not needed this frame.
+        int victim = -1;
+        for (std::size_t i = 0; i < m_slots.size(); ++i)
+        {
+            if (m_slots[i].last_used < m_frame &&
+                (victim < 0 || m_slots[i].last_used < m_slots[static_cast<size_t>(victim)].last_used))
+            {
+                victim = static_cast<int>(i);
+            }
+        }
+
+        if (victim >= 0)
+        {
+            m_chunk_slot[static_cast<size_t>(m_slots[static_cast<size_t>(victim)].chunk)] = -1;
+            m_slots[static_cast<size_t>(victim)] = Slot{};
+        }
+        return victim;
+    }
+
+    bool ChunkImpostors::render(SpriteRenderer &renderer, const StaticSpriteLayer &layer, uint32_t chunk, int slot, double now)
+    {
+        const int per_page = slots_per_page();
+        const int per_row = m_settings.page_size / m_settings.slot_size;
+        const int index = slot % per_page;
+        const int x = (index % per_row) * m_settings.slot_size;
+        const int y = (index / per_row) * m_settings.slot_size;
+        const int edge = m_settings.slot_size;
+
+        util::SpriteSheet &page = *m_pages[static_cast<size_t>(slot / per_page)];
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, page.base_sprite().texture.id(), 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        {
+            return false;
+        }
+
+        // Clear the whole slot (gutter included) to transparent, and its depth.
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(x, y, edge, edge);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glDisable(GL_SCISSOR_TEST);
+
+        glViewport(x + 1, y + 1, edge - 2, edge - 2);
+
+        // Top of the chunk lands in the slot's low rows, matching the sheet's
+        // top-left UV convention.
+        const util::Aabb &b = layer.chunk_bounds(chunk);
+        renderer.begin_batch(glm::ortho(b.min.x, b.max.x, b.min.y, b.max.y));
+        renderer.submit_static(layer.chunk_batch(chunk));
+        renderer.end_batch();
+
+        Slot &s = m_slots[static_cast<size_t>(slot)];
+        s.chunk = static_cast<int>(chunk);
+        s.version = layer.chunk_version(chunk);
+        s.rendered_at = now;
+        s.last_used = m_frame;
+        return true;
+    }
+
+    int ChunkImpostors::submit_visible(SpriteRenderer &renderer, const StaticSpriteLayer &layer, const util::Aabb &view)
+    {
+        m_visible.clear();
+        layer.visible_chunks(view, m_visible);
+
+        const int per_page = slots_per_page();
+        int drawn = 0;
+
+        for (const uint32_t chunk : m_visible)
+        {
+            const int slot = chunk < m_chunk_slot.size() ? m_chunk_slot[chunk] : -1;
+
+            // No impostor yet, or the chunk changed since: draw the real sprites.
+            if (slot < 0 || m_slots[static_cast<size_t>(slot)].version != layer.chunk_version(chunk))
+            {
+                renderer.submit_static(layer.chunk_batch(chunk));
+                continue;
+            }
+
+            const util::Aabb &b = layer.chunk_bounds(chunk);
+            renderer.submit(m_pages[static_cast<size_t>(slot / per_page)].get(),
+                            SpriteInstance{
+                                .pos = b.min,
+                                .size = b.max - b.min,
+                                .frame_index = static_cast<unsigned int>(slot % per_page),
+                                .layer = layer.chunk_batch(chunk).layer(),
+                            });
+            ++drawn;
+        }
+
+        return drawn;
+    }
+
+    void ChunkImpostors::invalidate()
+    {
+        std::fill(m_chunk_slot.begin(), m_chunk_slot.end(), -1);
+        std::fill(m_slots.begin(), m_slots.end(), Slot{});
+    }
+
+    void ChunkImpostors::release()
+    {
+        for (auto &page : m_pages)
+        {
+            for (SpriteRenderer *renderer : m_renderers)
+            {
+                renderer->unregister_sheet(*page);
+            }
+            page->base_sprite().texture.release();
+            page->uv_table().release();
+            page->trim_table().release();
+        }
+        m_pages.clear();
+        m_renderers.clear();
+        m_slots.clear();
+        m_chunk_slot.clear();
+        m_unsupported = false;
+
+        if (m_fbo)
+        {
+            glDeleteFramebuffers(1, &m_fbo);
+            m_fbo = 0;
+        }
+        if (m_depth)
+        {
+            glDeleteRenderbuffers(1, &m_depth);
+            m_depth = 0;
+        }
+    }
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <glad/gl.h>
+
+#include "sprite_renderer.hpp"
+#include "static_sprite_layer.hpp"
+#include "util/spatial_grid.hpp"
+#include "util/sprite_sheet.hpp"
+
+namespace renderer
+{
+    // Pre-rendered stand-ins for StaticSpriteLayer chunks at low zoom.
+    //
+    // Each chunk in view is rendered once into a slot of an impostor page (an
+    // RGBA8 texture split into square slots, wrapped as a SpriteSheet whose
+    // frames are the slots) and afterwards drawn as a single quad.
+    // - update() renders missing impostors first, then chunks rebuilt since
+    //   their impostor was made, then ones older than refresh_interval, at most
+    //   renders_per_frame per call.
+    // - Pages are created on demand up to max_pages; after that the least
+    //   recently drawn slot is reused, so memory is bounded by
+    //   max_pages * page_size^2 * 4 bytes.
+    // - If the driver reports a page framebuffer incomplete, every impostor is
+    //   dropped and available() turns false until release(); callers then draw
+    //   the layer directly (StaticSpriteLayer::submit_visible).
+    class ChunkImpostors
+    {
+    public:
+        struct Settings
+        {
+            int slot_size = 128;  // texels per impostor edge
+            int page_size = 1024; // texels per page edge
+            int max_pages = 8;
+
+            // Re-render visible impostors this often (animated content drifts).
+            double refresh_interval = 0.5;
+            int renders_per_frame = 8;
+        };
+
+        explicit ChunkImpostors(const Settings &settings);
+        ChunkImpostors() : ChunkImpostors(Settings{}) {}
+        ~ChunkImpostors();
+
+        ChunkImpostors(const ChunkImpostors &) = delete;
+        ChunkImpostors &operator=(const ChunkImpostors &) = delete;
+
+        // Renders pending impostors for chunks in `view`. Must be called
+        // outside begin_batch()/end_batch(); it runs batches of its own.
+        void update(SpriteRenderer &renderer, const StaticSpriteLayer &layer, const util::Aabb &view, double now);
+
+        // Inside a batch: one quad per visible chunk with an up-to-date
+        // impostor; other chunks submit their sprites. Returns impostors drawn.
+        int submit_visible(SpriteRenderer &renderer, const StaticSpriteLayer &layer, const util::Aabb &view);
+
+        // Drops every impostor (e.g. after a device-wide change in look).
+        void invalidate();
+
+        // False once an impostor framebuffer was incomplete.
+        bool available() const noexcept { return !m_unsupported; }
+
+        int pages() const noexcept { return static_cast<int>(m_pages.size()); }
+
+        // Frees the pages and unregisters them from every renderer that drew
+        // them (submit_visible), which must still be alive.
+        void release();
+
+    private:
+        struct Slot
+        {
+            int chunk = -1;
+            uint32_t version = 0;
+            double rendered_at = 0.0;
+            uint64_t last_used = 0;
+        };
+
+        struct Pending
+        {
+            uint32_t chunk;
+            int priority; // 0 missing, 1 rebuilt, 2 stale
+            double rendered_at;
+        };
+
+        int slots_per_page() const noexcept;
+        int acquire_slot();
+        // False, with nothing drawn, if the slot's page can't be rendered to.
+        bool render(SpriteRenderer &renderer, const StaticSpriteLayer &layer, uint32_t chunk, int slot, double now);
+
+        Settings m_settings;
+
+        std::vector<std::unique_ptr<util::SpriteSheet>> m_pages;
+        std::vector<SpriteRenderer *> m_renderers; // drew the pages
+        std::vector<Slot> m_slots;         // page * slots_per_page + index
+        std::vector<int> m_chunk_slot;     // chunk -> slot, -1 = none
+
+        GLuint m_fbo{};
+        GLuint m_depth{}; // page_size^2, shared by every page
+        uint64_t m_frame = 0;
+        bool m_unsupported = false;
+
+        std::vector<uint32_t> m_visible;
+        std::vector<Pending> m_pending;
+    };
+}
@@ -0,0 +1,83 @@
+#include "gl_extensions.hpp"
+
+#include <cstring>
+
+namespace renderer
+{
+    namespace
+    {
+        GlExtensions g_extensions{};
+
+        template <typename T>
+        T load_proc(GLADloadfunc load, const char *name)
+        {
+            return reinterpret_cast<T>(load(name));
+        }
+    }
+
+    bool has_gl_extension(const char *name)
+    {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+        for (GLint i = 0; i < count; ++i)
+        {
+            const auto *ext = reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+            if (ext && std::strcmp(ext, name) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void load_gl_extensions(GLADloadfunc load)
+    {
+        GlExtensions ext{};
+
+        glGetIntegerv(GL_MAJOR_VERSION, &ext.major);
+        glGetIntegerv(GL_MINOR_VERSION, &ext.minor);
+
+        if (ext.version_at_least(4, 4) || has_gl_extension("GL_ARB_buffer_storage"))
+        {
+            ext.BufferStorage = load_proc<PFN_glBufferStorage>(load, "glBufferStorage");
+            ext.buffer_storage = ext.BufferStorage != nullptr;
+        }
+
+        if (ext.version_at_least(4, 3) ||
+            (has_gl_extension("GL_ARB_multi_draw_indirect") &&
+             (ext.version_at_least(4, 2) || has_gl_extension("GL_ARB_base_instance"))))
+        {
+            ext.MultiDrawArraysIndirect = load_proc<PFN_glMultiDrawArraysIndirect>(load, "glMultiDrawArraysIndirect");
+            ext.multi_draw_indirect = ext.MultiDrawArraysIndirect != nullptr;
+        }
+
+        if (ext.version_at_least(4, 1) || has_gl_extension("GL_ARB_get_program_binary"))
+        {
+            GLint formats = 0;
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+
+            ext.GetProgramBinary = load_proc<PFN_glGetProgramBinary>(load, "glGetProgramBinary");
+            ext.ProgramBinary = load_proc<PFN_glProgramBinary>(load, "glProgramBinary");
+            ext.ProgramParameteri = load_proc<PFN_glProgramParameteri>(load, "glProgramParameteri");
+            ext.program_binary = formats > 0 && ext.GetProgramBinary && ext.ProgramBinary && ext.ProgramParameteri;
+        }
+
+        if (has_gl_extension("GL_KHR_parallel_shader_compile"))
+        {
+            ext.MaxShaderCompilerThreads = load_proc<PFN_glMaxShaderCompilerThreads>(load, "glMaxShaderCompilerThreadsKHR");
+        }
+        else if (has_gl_extension("GL_ARB_parallel_shader_compile"))
+        {
+            ext.MaxShaderCompilerThreads = load_proc<PFN_glMaxShaderCompilerThreads>(load, "glMaxShaderCompilerThreadsARB");
+        }
+        ext.parallel_shader_compile = ext.MaxShaderCompilerThreads != nullptr;
+
+        g_extensions = ext;
+    }
+
+    const GlExtensions &gl_extensions() noexcept
+    {
+        return g_extensions;
+    }
+}
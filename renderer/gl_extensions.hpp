@@ -0,0 +1,85 @@
+#pragma once
+
+#include <glad/gl.h>
+
+// The glad loader in external/ is generated for core 3.3 with no extensions.
+// Newer entry points are resolved here, at runtime, through the same loader
+// function so the renderer can use them when the driver offers them.
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+#ifndef GL_DYNAMIC_STORAGE_BIT
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#endif
+#ifndef GL_CLIENT_STORAGE_BIT
+#define GL_CLIENT_STORAGE_BIT 0x0200
+#endif
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+#ifndef GL_MAX_SHADER_COMPILER_THREADS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+namespace renderer
+{
+    using PFN_glBufferStorage = void(GLAD_API_PTR *)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+    using PFN_glMultiDrawArraysIndirect = void(GLAD_API_PTR *)(GLenum mode, const void *indirect, GLsizei drawcount, GLsizei stride);
+    using PFN_glGetProgramBinary = void(GLAD_API_PTR *)(GLuint program, GLsizei buf_size, GLsizei *length, GLenum *binary_format, void *binary);
+    using PFN_glProgramBinary = void(GLAD_API_PTR *)(GLuint program, GLenum binary_format, const void *binary, GLsizei length);
+    using PFN_glProgramParameteri = void(GLAD_API_PTR *)(GLuint program, GLenum pname, GLint value);
+    using PFN_glMaxShaderCompilerThreads = void(GLAD_API_PTR *)(GLuint count);
+
+    struct GlExtensions
+    {
+        int major = 0;
+        int minor = 0;
+
+        // GL 4.4 / ARB_buffer_storage
+        bool buffer_storage = false;
+        PFN_glBufferStorage BufferStorage = nullptr;
+
+        // GL 4.3 / ARB_multi_draw_indirect (+ base instance, so baseInstance is honoured)
+        bool multi_draw_indirect = false;
+        PFN_glMultiDrawArraysIndirect MultiDrawArraysIndirect = nullptr;
+
+        // GL 4.1 / ARB_get_program_binary, and the driver exposes at least one format
+        bool program_binary = false;
+        PFN_glGetProgramBinary GetProgramBinary = nullptr;
+        PFN_glProgramBinary ProgramBinary = nullptr;
+        PFN_glProgramParameteri ProgramParameteri = nullptr;
+
+        // KHR_parallel_shader_compile (or the ARB variant): compiles and links
+        // return immediately and GL_COMPLETION_STATUS_KHR can be polled.
+        bool parallel_shader_compile = false;
+        PFN_glMaxShaderCompilerThreads MaxShaderCompilerThreads = nullptr;
+
+        bool version_at_least(int maj, int min) const noexcept
+        {
+            return major > maj || (major == maj && minor >= min);
+        }
+    };
+
+    // Must be called once after gladLoadGL, with the same loader function.
+    void load_gl_extensions(GLADloadfunc load);
+
+    const GlExtensions &gl_extensions() noexcept;
+
+    bool has_gl_extension(const char *name);
+}
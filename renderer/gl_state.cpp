@@ -0,0 +1,155 @@
+#include "gl_state.hpp"
+
+namespace renderer
+{
+    bool GlState::changed(GLuint &cached, GLuint value) noexcept
+    {
+        if (cached == value)
+        {
+            ++m_stats.elided;
+            return false;
+        }
+
+        cached = value;
+        ++m_stats.issued;
+        return true;
+    }
+
+    void GlState::use_program(GLuint program)
+    {
+        if (changed(m_program, program))
+        {
+            glUseProgram(program);
+        }
+    }
+
+    void GlState::bind_vertex_array(GLuint vao)
+    {
+        if (changed(m_vao, vao))
+        {
+            glBindVertexArray(vao);
+        }
+    }
+
+    void GlState::bind_array_buffer(GLuint buffer)
+    {
+        if (changed(m_array_buffer, buffer))
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        }
+    }
+
+    void GlState::bind_texture(GLuint unit, GLenum target, GLuint texture)
+    {
+        int slot = TargetCount;
+        switch (target)
+        {
+        case GL_TEXTURE_2D:
+            slot = Texture2D;
+            break;
+        case GL_TEXTURE_2D_ARRAY:
+            slot = Texture2DArray;
+            break;
+        case GL_TEXTURE_BUFFER:
+            slot = TextureBuffer;
+            break;
+        default:
+            break;
+        }
+
+        if (unit >= MaxTextureUnits || slot == TargetCount)
+        {
+            // Untracked: issue it and forget what the active unit is.
+            glActiveTexture(GL_TEXTURE0 + unit);
+            glBindTexture(target, texture);
+            m_active_unit = unit;
+            m_stats.issued += 2;
+            ++m_stats.texture_binds;
+            return;
+        }
+
+        if (m_textures[unit][slot] == texture)
+        {
+            ++m_stats.elided;
+            return;
+        }
+
+        if (changed(m_active_unit, unit))
+        {
+            glActiveTexture(GL_TEXTURE0 + unit);
+        }
+
+        m_textures[unit][slot] = texture;
+        ++m_stats.issued;
+        ++m_stats.texture_binds;
+        glBindTexture(target, texture);
+    }
+
+    void GlState::enable_blend(bool enabled)
+    {
+        if (changed(m_blend, enabled ? 1u : 0u))
+        {
+            ++m_stats.blend_changes;
+            enabled ? glEnable(GL_BLEND) : glDisable(GL_BLEND);
+        }
+    }
+
+    void GlState::blend_func(GLenum src, GLenum dst)
+    {
+        if (m_blend_src == src && m_blend_dst == dst)
+        {
+            ++m_stats.elided;
+            return;
+        }
+
+        m_blend_src = src;
+        m_blend_dst = dst;
+        ++m_stats.issued;
+        ++m_stats.blend_changes;
+        glBlendFunc(src, dst);
+    }
+
+    void GlState::enable_depth_test(bool enabled)
+    {
+        if (changed(m_depth_test, enabled ? 1u : 0u))
+        {
+            enabled ? glEnable(GL_DEPTH_TEST) : glDisable(GL_DEPTH_TEST);
+        }
+    }
+
+    void GlState::depth_mask(bool write)
+    {
+        if (changed(m_depth_mask, write ? 1u : 0u))
+        {
+            glDepthMask(write ? GL_TRUE : GL_FALSE);
+        }
+    }
+
+    void GlState::depth_func(GLenum func)
+    {
+        if (changed(m_depth_func, func))
+        {
+            glDepthFunc(func);
+        }
+    }
+
+    void GlState::invalidate() noexcept
+    {
+        m_program = Unknown;
+        m_vao = Unknown;
+        m_array_buffer = Unknown;
+        m_active_unit = Unknown;
+        for (auto &unit : m_textures)
+        {
+            unit.fill(Unknown);
+        }
+
+        m_blend = Unknown;
+        m_blend_src = UnknownEnum;
+        m_blend_dst = UnknownEnum;
+
+        m_depth_test = Unknown;
+        m_depth_mask = Unknown;
+        m_depth_func = UnknownEnum;
+    }
+}
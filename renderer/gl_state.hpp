@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <glad/gl.h>
+
+namespace renderer
+{
+    // Shadow copy of the GL bindings the sprite renderer touches, so redundant
+    // state changes are dropped on the CPU instead of reaching the driver.
+    //
+    // Only valid while every change of the tracked state goes through it; call
+    // invalidate() after foreign code (texture loads, other renderers) may have
+    // changed bindings behind its back.
+    class GlState
+    {
+    public:
+        // Calls issued to / elided before the driver since reset_stats().
+        struct Stats
+        {
+            std::uint32_t issued = 0;
+            std::uint32_t elided = 0;
+            std::uint32_t draws = 0;
+
+            // Subsets of `issued`.
+            std::uint32_t texture_binds = 0;
+            std::uint32_t blend_changes = 0;
+        };
+
+        // Texture units tracked; binds to higher units always go through.
+        static constexpr GLuint MaxTextureUnits = 16;
+
+        GlState() noexcept { invalidate(); }
+
+        void use_program(GLuint program);
+        void bind_vertex_array(GLuint vao);
+        void bind_array_buffer(GLuint buffer);
+
+        // target: GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY or GL_TEXTURE_BUFFER.
+        void bind_texture(GLuint unit, GLenum target, GLuint texture);
+
+        void enable_blend(bool enabled);
+        void blend_func(GLenum src, GLenum dst);
+
+        void enable_depth_test(bool enabled);
+        void depth_mask(bool write);
+        void depth_func(GLenum func);
+
+        // Counts a cached uniform upload (see Shader::set) against the same stats.
+        void count_uniform(bool issued) noexcept { issued ? ++m_stats.issued : ++m_stats.elided; }
+
+        void count_draw() noexcept { ++m_stats.draws; }
+
+        // For code that binds GL_ARRAY_BUFFER itself (e.g. InstanceRing).
+        void forget_array_buffer() noexcept { m_array_buffer = Unknown; }
+
+        // Forget everything; the next change of each binding is always issued.
+        void invalidate() noexcept;
+
+        const Stats &stats() const noexcept { return m_stats; }
+        void reset_stats() noexcept { m_stats = {}; }
+
+    private:
+        enum TargetSlot
+        {
+            Texture2D,
+            Texture2DArray,
+            TextureBuffer,
+            TargetCount
+        };
+
+        // "Unknown" so the first call after invalidate() is never elided.
+        static constexpr GLuint Unknown = 0xFFFFFFFFu;
+        static constexpr GLenum UnknownEnum = 0xFFFFFFFFu;
+
+        bool changed(GLuint &cached, GLuint value) noexcept;
+
+        GLuint m_program = Unknown;
+        GLuint m_vao = Unknown;
+        GLuint m_array_buffer = Unknown;
+        GLuint m_active_unit = Unknown;
+        std::array<std::array<GLuint, TargetCount>, MaxTextureUnits> m_textures{};
+
+        GLuint m_blend = Unknown; // 0/1
+        GLenum m_blend_src = UnknownEnum;
+        GLenum m_blend_dst = UnknownEnum;
+
+        GLuint m_depth_test = Unknown; // 0/1
+        GLuint m_depth_mask = Unknown; // 0/1
+        GLenum m_depth_func = UnknownEnum;
+
+        Stats m_stats;
+    };
+}
@@ -0,0 +1,487 @@
+#include "glyph_cache.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "util/profiler.hpp"
+#include "util/utf8.hpp"
+
+namespace renderer
+{
+    namespace
+    {
+        // Texels between glyphs; each glyph already carries its range border.
+        constexpr int GlyphPadding = 1;
+    }
+
+    GlyphCache::GlyphCache(const Settings &settings)
+        : m_settings(settings)
+    {
+        m_settings.max_pages = std::max(m_settings.max_pages, 2);
+    }
+
+    GlyphCache::~GlyphCache()
+    {
+        release();
+    }
+
+    bool GlyphCache::open(const std::string &font_path)
+    {
+        PROFILE_SCOPE("GlyphCache::open");
+
+        release();
+
+        if (!m_rasterizer.open(font_path, m_settings.pixel_height, m_settings.range_px))
+        {
+            return false;
+        }
+        m_line_height = m_rasterizer.ascender();
+
+        // The placeholder is baked here, on the calling thread, and its page
+        // is never evicted.
+        util::RasterGlyph raster;
+        for (const char32_t codepoint : {util::ReplacementChar, U'?'})
+        {
+            if (!m_rasterizer.rasterize(codepoint, raster))
+            {
+                continue;
+            }
+
+            Glyph &glyph = m_glyphs[codepoint];
+            if (place(raster, glyph) && glyph.state == GlyphState::Resident)
+            {
+                m_placeholder = glyph;
+                m_pages[glyph.page]->pinned = true;
+            }
+            break;
+        }
+
+        for (auto &page : m_pages)
+        {
+            page->sheet.set_uv_rects(page->uv_rects);
+            page->dirty = false;
+        }
+
+        m_stop = false;
+        m_worker = std::thread(&GlyphCache::worker_loop, this);
+        return true;
+    }
+
+    void GlyphCache::worker_loop()
+    {
+        for (;;)
+        {
+            char32_t codepoint = 0;
+            {
+                std::unique_lock lock(m_mutex);
+                m_wake.wait(lock, [this] { return m_stop || !m_requests.empty(); });
+                if (m_stop)
+                {
+                    return;
+                }
+                codepoint = m_requests.front();
+                m_requests.pop_front();
+            }
+
+            util::RasterGlyph raster;
+            m_rasterizer.rasterize(codepoint, raster);
+
+            std::lock_guard lock(m_mutex);
+            m_done.push_back(std::move(raster));
+        }
+    }
+
+    void GlyphCache::update()
+    {
+        PROFILE_SCOPE("GlyphCache::update");
+
+        ++m_frame;
+        m_uploaded = 0;
+
+        {
+            std::lock_guard lock(m_mutex);
+            for (auto &raster : m_done)
+            {
+                m_ready.push_back(std::move(raster));
+            }
+            m_done.clear();
+        }
+
+        // Evicted pages finish clearing before any new glyph is placed.
+        for (auto &page : m_pages)
+        {
+            clear_stale(*page);
+        }
+
+        while (!m_ready.empty())
+        {
+            const util::RasterGlyph &raster = m_ready.front();
+
+            auto it = m_glyphs.find(raster.codepoint);
+            if (it == m_glyphs.end() || it->second.state != GlyphState::Pending)
+            {
+                m_ready.pop_front();
+                continue;
+            }
+
+            // Always take one glyph, so a large one can't stall the queue.
+            if (m_uploaded > 0 && m_uploaded + raster.rgba.size() > m_settings.upload_budget)
+            {
+                break;
+            }
+
+            // Every page drawn recently: retry next frame.
+            if (!place(raster, it->second))
+            {
+                break;
+            }
+
+            --m_pending;
+            m_ready.pop_front();
+        }
+
+        for (auto &page : m_pages)
+        {
+            if (page->dirty)
+            {
+                page->sheet.set_uv_rects(page->uv_rects);
+                page->dirty = false;
+            }
+        }
+    }
+
+    bool GlyphCache::place(const util::RasterGlyph &raster, Glyph &glyph)
+    {
+        const int limit = m_settings.page_size - 2 * GlyphPadding;
+        if (!raster.found || raster.width > limit || raster.height > limit)
+        {
+            glyph.state = GlyphState::Missing;
+            return true;
+        }
+
+        int x = 0;
+        int y = 0;
+        std::size_t index = 0;
+        while (index < m_pages.size() && !allocate(*m_pages[index], raster.width, raster.height, x, y))
+        {
+            ++index;
+        }
+
+        if (index == m_pages.size())
+        {
+            if (static_cast<int>(m_pages.size()) < m_settings.max_pages)
+            {
+                new_page();
+            }
+            else
+            {
+                // A page evicted earlier is still being cleared: wait for it
+                // rather than evict another.
+                if (std::any_of(m_pages.begin(), m_pages.end(), [](const auto &page) { return !page->stale.empty(); }))
+                {
+                    return false;
+                }
+
+                // Evict the least recently drawn page not drawn last frame
+                // either (render_text runs after update in a frame).
+                std::size_t victim = m_pages.size();
+                for (std::size_t i = 0; i < m_pages.size(); ++i)
+                {
+                    const Page &page = *m_pages[i];
+                    if (!page.pinned && page.last_used + 1 < m_frame &&
+                        (victim == m_pages.size() || page.last_used < m_pages[victim]->last_used))
+                    {
+                        victim = i;
+                    }
+                }
+                if (victim == m_pages.size())
+                {
+                    return false;
+                }
+
+                reset_page(*m_pages[victim]);
+                ++m_evictions;
+                if (!clear_stale(*m_pages[victim]))
+                {
+                    return false;
+                }
+                index = victim;
+            }
+
+            if (!allocate(*m_pages[index], raster.width, raster.height, x, y))
+            {
+                glyph.state = GlyphState::Missing;
+                return true;
+            }
+        }
+
+        Page &page = *m_pages[index];
+
+        glBindTexture(GL_TEXTURE_2D, page.sheet.base_sprite().texture.id());
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, raster.width, raster.height, GL_RGBA, GL_UNSIGNED_BYTE,
+                        raster.rgba.data());
+        glBindTexture(GL_TEXTURE_2D, 0);
+        m_uploaded += raster.rgba.size();
+
+        // Rows are stored bottom-up (see RasterGlyph), so v runs y+h -> y,
+        // as in MsdfFont.
+        const float inv = 1.0f / static_cast<float>(m_settings.page_size);
+        glyph.state = GlyphState::Resident;
+        glyph.page = static_cast<uint16_t>(index);
+        glyph.frame = static_cast<uint16_t>(page.uv_rects.size());
+        glyph.advance = raster.advance;
+        glyph.bearingX = raster.bearingX;
+        glyph.bearingY = raster.bearingY;
+        glyph.w = static_cast<float>(raster.width);
+        glyph.h = static_cast<float>(raster.height);
+
+        page.uv_rects.emplace_back(static_cast<float>(x) * inv, static_cast<float>(y + raster.height) * inv,
+                                   static_cast<float>(x + raster.width) * inv, static_cast<float>(y) * inv);
+        page.glyphs.push_back(raster.codepoint);
+        page.dirty = true;
+        ++m_resident;
+        return true;
+    }
+
+    bool GlyphCache::allocate(Page &page, int w, int h, int &x, int &y) const
+    {
+        if (!page.stale.empty() || page.uv_rects.size() >= 0xFFFF)
+        {
+            return false;
+        }
+
+        if (page.pen_x + w + GlyphPadding > m_settings.page_size)
+        {
+            page.pen_x = GlyphPadding;
+            page.pen_y += page.row_h + GlyphPadding;
+            page.row_h = 0;
+        }
+        if (page.pen_y + h + GlyphPadding > m_settings.page_size)
+        {
+            return false;
+        }
+
+        x = page.pen_x;
+        y = page.pen_y;
+        page.pen_x += w + GlyphPadding;
+        page.row_h = std::max(page.row_h, h);
+        return true;
+    }
+
+    GlyphCache::Page &GlyphCache::new_page()
+    {
+        auto page = std::make_unique<Page>();
+        auto &sprite = page->sheet.base_sprite();
+        sprite.texture.create(m_settings.page_size, m_settings.page_size);
+        sprite.texture.set_filtering(GL_LINEAR, GL_LINEAR);
+        sprite.sprite_width = m_settings.page_size;
+        sprite.sprite_height = m_settings.page_size;
+        page->last_used = m_frame;
+        page->pen_x = GlyphPadding;
+        page->pen_y = GlyphPadding;
+
+        // Zeroed storage, once per page, so linear filtering at glyph edges
+        // never reads undefined texels. Not counted against upload_budget:
+        // it happens at most max_pages times.
+        const std::vector<unsigned char> zeros(
+            static_cast<std::size_t>(m_settings.page_size) * static_cast<std::size_t>(m_settings.page_size) * 4);
+        glBindTexture(GL_TEXTURE_2D, sprite.texture.id());
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_settings.page_size, m_settings.page_size, 0, GL_RGBA,
+                     GL_UNSIGNED_BYTE, zeros.data());
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        m_pages.push_back(std::move(page));
+        return *m_pages.back();
+    }
+
+    void GlyphCache::reset_page(Page &page)
+    {
+        for (const char32_t codepoint : page.glyphs)
+        {
+            m_glyphs.erase(codepoint);
+            --m_resident;
+        }
+
+        // Old glyphs are cleared so linear filtering at the edges of new ones
+        // never reads their texels. Shelf packing places a row's glyphs one
+        // after another at the same y, so each row becomes one rect.
+        const float size = static_cast<float>(m_settings.page_size);
+        for (const glm::vec4 &uv : page.uv_rects)
+        {
+            const int x0 = static_cast<int>(std::lround(uv.x * size));
+            const int x1 = static_cast<int>(std::lround(uv.z * size));
+            const int y0 = static_cast<int>(std::lround(uv.w * size));
+            const int y1 = static_cast<int>(std::lround(uv.y * size));
+
+            if (!page.stale.empty() && page.stale.back().y == y0)
+            {
+                Rect &row = page.stale.back();
+                row.w = x1 - row.x;
+                row.h = std::max(row.h, y1 - y0);
+            }
+            else
+            {
+                page.stale.push_back(Rect{x0, y0, x1 - x0, y1 - y0});
+            }
+        }
+
+        page.glyphs.clear();
+        page.uv_rects.clear();
+        page.dirty = true;
+
+        page.pen_x = GlyphPadding;
+        page.pen_y = GlyphPadding;
+        page.row_h = 0;
+    }
+
+    bool GlyphCache::clear_stale(Page &page)
+    {
+        while (!page.stale.empty())
+        {
+            const Rect rect = page.stale.back();
+            const std::size_t bytes = static_cast<std::size_t>(rect.w) * static_cast<std::size_t>(rect.h) * 4;
+
+            // Like glyphs, always take one rect so a large one can't stall.
+            if (m_uploaded > 0 && m_uploaded + bytes > m_settings.upload_budget)
+            {
+                return false;
+            }
+
+            if (m_zeros.size() < bytes)
+            {
+                m_zeros.resize(bytes);
+            }
+            glBindTexture(GL_TEXTURE_2D, page.sheet.base_sprite().texture.id());
+            glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x, rect.y, rect.w, rect.h, GL_RGBA, GL_UNSIGNED_BYTE,
+                            m_zeros.data());
+            glBindTexture(GL_TEXTURE_2D, 0);
+
+            m_uploaded += bytes;
+            page.stale.pop_back();
+        }
+        return true;
+    }
+
+    const GlyphCache::Glyph *GlyphCache::lookup(char32_t codepoint)
+    {
+        auto [it, inserted] = m_glyphs.try_emplace(codepoint);
+        if (inserted)
+        {
+            m_new_requests.push_back(codepoint);
+            ++m_pending;
+        }
+        return &it->second;
+    }
+
+    void GlyphCache::render_text(SpriteRenderer &renderer, std::string_view text, glm::vec2 pos, float scale, uint8_t layer)
+    {
+        if (!is_open())
+        {
+            return;
+        }
+        if (std::find(m_renderers.begin(), m_renderers.end(), &renderer) == m_renderers.end())
+        {
+            m_renderers.push_back(&renderer);
+        }
+
+        m_page_runs.resize(m_pages.size());
+        for (auto &run : m_page_runs)
+        {
+            run.clear();
+        }
+
+        float cursor_x = 0.0f;
+        const float baseline_y = m_line_height * scale;
+
+        for (size_t i = 0; i < text.size();)
+        {
+            const char32_t cp = util::next_code_point(text, i);
+
+            const Glyph *g = nullptr;
+            if (cp >= 32 && !(cp >= 0x7F && cp < 0xA0))
+            {
+                g = lookup(cp);
+                if (g->state != GlyphState::Resident)
+                {
+                    g = &m_placeholder;
+                }
+            }
+
+            // Control characters, or no placeholder: a half-line gap.
+            if (!g || g->state != GlyphState::Resident)
+            {
+                cursor_x += m_line_height * 0.5f * scale;
+                continue;
+            }
+
+            Page &page = *m_pages[g->page];
+            page.last_used = m_frame;
+
+            m_page_runs[g->page].push_back(pack_instance(page.sheet, SpriteInstance{
+                .pos = {cursor_x + g->bearingX * scale, baseline_y - g->bearingY * scale},
+                .size = {g->w * scale, g->h * scale},
+                .frame_index = g->frame}));
+
+            cursor_x += g->advance * scale;
+        }
+
+        if (!m_new_requests.empty())
+        {
+            {
+                std::lock_guard lock(m_mutex);
+                m_requests.insert(m_requests.end(), m_new_requests.begin(), m_new_requests.end());
+            }
+            m_wake.notify_one();
+            m_new_requests.clear();
+        }
+
+        for (std::size_t i = 0; i < m_page_runs.size(); ++i)
+        {
+            if (!m_page_runs[i].empty())
+            {
+                renderer.submit_glyphs(&m_pages[i]->sheet, m_page_runs[i], pos, layer);
+            }
+        }
+    }
+
+    void GlyphCache::release()
+    {
+        if (m_worker.joinable())
+        {
+            {
+                std::lock_guard lock(m_mutex);
+                m_stop = true;
+            }
+            m_wake.notify_all();
+            m_worker.join();
+        }
+        m_requests.clear();
+        m_done.clear();
+        m_ready.clear();
+        m_new_requests.clear();
+        m_rasterizer.close();
+
+        for (auto &page : m_pages)
+        {
+            for (SpriteRenderer *renderer : m_renderers)
+            {
+                renderer->unregister_sheet(page->sheet);
+            }
+            page->sheet.base_sprite().texture.release();
+            page->sheet.uv_table().release();
+            page->sheet.trim_table().release();
+        }
+        m_pages.clear();
+        m_renderers.clear();
+        m_page_runs.clear();
+        m_zeros.clear();
+        m_zeros.shrink_to_fit();
+
+        m_glyphs.clear();
+        m_placeholder = Glyph{GlyphState::Missing};
+        m_line_height = 0.0f;
+        m_resident = 0;
+        m_pending = 0;
+        m_uploaded = 0;
+    }
+}
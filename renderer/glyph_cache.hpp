@@ -0,0 +1,172 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+
+#include "sprite_renderer.hpp"
+#include "util/glyph_rasterizer.hpp"
+#include "util/sprite_sheet.hpp"
+
+namespace renderer
+{
+    // MSDF glyphs rendered on demand from a font file, for text the prebuilt
+    // atlas (util::MsdfFont) doesn't cover: player names, localised strings.
+    //
+    // - render_text() lays out UTF-8 and queues code points it hasn't seen
+    //   for a worker thread, which rasterises them (util::GlyphRasterizer).
+    //   Until a glyph is resident it draws as the font's U+FFFD (or '?'),
+    //   baked when the font is opened, so text never waits on the worker.
+    // - update() packs finished glyphs into atlas pages (RGBA8 textures
+    //   wrapped as SpriteSheets whose frames are the glyphs) with
+    //   glTexSubImage2D, at most upload_budget bytes per call.
+    // - Pages are created on demand up to max_pages, zeroed at creation;
+    //   after that the least recently drawn page not drawn this frame is
+    //   reused, and its glyphs go back to being requested when next drawn.
+    //   Only the rows its old glyphs covered are cleared, within the same
+    //   upload budget and spread over frames; the page takes no new glyphs
+    //   until it is clean.
+    class GlyphCache
+    {
+    public:
+        struct Settings
+        {
+            int pixel_height = 48; // roughly the EM height, like atlas_generator
+            int range_px = 6;      // distance field range
+            int page_size = 1024;  // texels per page edge
+            int max_pages = 4;     // at least 2: the first page is pinned
+
+            std::size_t upload_budget = 256 * 1024; // bytes per update()
+        };
+
+        explicit GlyphCache(const Settings &settings);
+        GlyphCache() : GlyphCache(Settings{}) {}
+        ~GlyphCache();
+
+        GlyphCache(const GlyphCache &) = delete;
+        GlyphCache &operator=(const GlyphCache &) = delete;
+
+        // Opens the font, bakes the placeholder and starts the worker.
+        bool open(const std::string &font_path);
+        bool is_open() const noexcept { return m_worker.joinable(); }
+
+        // Once per frame, outside begin_batch()/end_batch().
+        void update();
+
+        // Inside a Font batch; one submit_glyphs per page the text touches.
+        void render_text(SpriteRenderer &renderer, std::string_view text, glm::vec2 pos,
+                         float scale = 1.0f, uint8_t layer = 0);
+
+        float line_height() const noexcept { return m_line_height; }
+
+        int pages() const noexcept { return static_cast<int>(m_pages.size()); }
+        std::size_t resident() const noexcept { return m_resident; }
+        std::size_t pending() const noexcept { return m_pending; }
+        std::uint64_t evictions() const noexcept { return m_evictions; }
+        std::size_t bytes_uploaded() const noexcept { return m_uploaded; } // by the last update()
+
+        // Stops the worker and frees every page; needs the GL context. Pages
+        // are unregistered from every renderer that drew them, which must
+        // still be alive.
+        void release();
+
+    private:
+        enum class GlyphState : uint8_t
+        {
+            Pending,
+            Resident,
+            Missing // not in the font: draws as the placeholder
+        };
+
+        struct Glyph
+        {
+            GlyphState state = GlyphState::Pending;
+            uint16_t page = 0;
+            uint16_t frame = 0;
+            float advance = 0.0f;
+            float bearingX = 0.0f;
+            float bearingY = 0.0f;
+            float w = 0.0f;
+            float h = 0.0f;
+        };
+
+        struct Rect
+        {
+            int x = 0;
+            int y = 0;
+            int w = 0;
+            int h = 0;
+        };
+
+        struct Page
+        {
+            util::SpriteSheet sheet;
+            std::vector<glm::vec4> uv_rects; // frame -> rect, uploaded when dirty
+            std::vector<char32_t> glyphs;    // resident code points, for eviction
+            std::vector<Rect> stale;         // texels still holding evicted glyphs
+
+            // Shelf packing: glyphs fill rows left to right, rows top to bottom.
+            int pen_x = 0;
+            int pen_y = 0;
+            int row_h = 0;
+
+            uint64_t last_used = 0;
+            bool pinned = false;
+            bool dirty = false;
+        };
+
+        void worker_loop();
+
+        // Resident glyph for `raster`, or false if no page has room this frame.
+        bool place(const util::RasterGlyph &raster, Glyph &glyph);
+        bool allocate(Page &page, int w, int h, int &x, int &y) const;
+        Page &new_page();
+        void reset_page(Page &page);
+
+        // Zeroes stale rects within the upload budget; true once none are left.
+        bool clear_stale(Page &page);
+
+        const Glyph *lookup(char32_t codepoint);
+
+        Settings m_settings;
+
+        std::vector<std::unique_ptr<Page>> m_pages;
+        std::vector<SpriteRenderer *> m_renderers; // drew the pages (render_text)
+        std::unordered_map<char32_t, Glyph> m_glyphs;
+        Glyph m_placeholder{GlyphState::Missing};
+        float m_line_height = 0.0f;
+
+        uint64_t m_frame = 0;
+        std::size_t m_resident = 0;
+        std::size_t m_pending = 0;
+        std::uint64_t m_evictions = 0;
+        std::size_t m_uploaded = 0;
+
+        // Finished glyphs waiting for upload budget or page space.
+        std::deque<util::RasterGlyph> m_ready;
+
+        // render_text scratch: requests to hand over, instances per page.
+        std::vector<char32_t> m_new_requests;
+        std::vector<std::vector<GpuSpriteInstance>> m_page_runs;
+        std::vector<unsigned char> m_zeros;
+
+        // Worker side. m_rasterizer belongs to the worker once it runs.
+        util::GlyphRasterizer m_rasterizer;
+        std::thread m_worker;
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::deque<char32_t> m_requests;        // guarded by m_mutex
+        std::vector<util::RasterGlyph> m_done;  // guarded by m_mutex
+        bool m_stop = false;                    // guarded by m_mutex
+    };
+}
@@ -0,0 +1,112 @@
+#include "gpu_timer.hpp"
+
+#include <algorithm>
+
+namespace renderer
+{
+    GpuTimer::~GpuTimer()
+    {
+        release();
+    }
+
+    void GpuTimer::set_section_count(std::size_t count)
+    {
+        m_section_ms.assign(count, 0.0);
+    }
+
+    void GpuTimer::begin(std::size_t section)
+    {
+        if (m_open == static_cast<int>(section))
+        {
+            return;
+        }
+        end();
+
+        Frame &frame = m_frames[m_frame];
+        if (frame.used == frame.queries.size())
+        {
+            GLuint query = 0;
+            glGenQueries(1, &query);
+            frame.queries.push_back(query);
+            frame.sections.push_back(0);
+        }
+
+        frame.sections[frame.used] = static_cast<std::uint32_t>(section);
+        glBeginQuery(GL_TIME_ELAPSED, frame.queries[frame.used]);
+        ++frame.used;
+
+        m_open = static_cast<int>(section);
+    }
+
+    void GpuTimer::end()
+    {
+        if (m_open < 0)
+        {
+            return;
+        }
+        glEndQuery(GL_TIME_ELAPSED);
+        m_open = -1;
+    }
+
+    void GpuTimer::end_frame()
+    {
+        end();
+
+        m_frame = (m_frame + 1) % FrameLatency;
+        collect(m_frames[m_frame]);
+    }
+
+    void GpuTimer::collect(Frame &frame)
+    {
+        // Never leave an older frame's times behind: a frame without queries
+        // took no time, and a dropped one reads as zero and stale.
+        std::fill(m_section_ms.begin(), m_section_ms.end(), 0.0);
+        m_stale = false;
+
+        if (frame.used == 0)
+        {
+            return;
+        }
+
+        // Queries complete in order; the last one covers the rest.
+        GLuint available = GL_FALSE;
+        glGetQueryObjectuiv(frame.queries[frame.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+        {
+            ++m_dropped;
+            m_stale = true;
+            frame.used = 0;
+            return;
+        }
+
+        for (std::size_t i = 0; i < frame.used; ++i)
+        {
+            GLuint64 ns = 0;
+            glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &ns);
+
+            const std::size_t section = frame.sections[i];
+            if (section < m_section_ms.size())
+            {
+                m_section_ms[section] += static_cast<double>(ns) * 1e-6;
+            }
+        }
+
+        frame.used = 0;
+    }
+
+    void GpuTimer::release()
+    {
+        end();
+
+        for (Frame &frame : m_frames)
+        {
+            if (!frame.queries.empty())
+            {
+                glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+            }
+            frame.queries.clear();
+            frame.sections.clear();
+            frame.used = 0;
+        }
+    }
+}
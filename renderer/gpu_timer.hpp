@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glad/gl.h>
+
+namespace renderer
+{
+    // GL_TIME_ELAPSED queries attributed to caller-defined sections.
+    //
+    // Queries are double-buffered by frame: results of a frame are read back
+    // when its buffer comes around again, one frame later, so reading them
+    // never stalls the CPU on the GPU. A frame whose results are still not
+    // available by then is dropped rather than waited for, and reported as
+    // stale.
+    //
+    // Elapsed-time queries cannot nest, so sections are sequential: begin()
+    // closes whatever section is open. Re-entering the open section keeps the
+    // running query, so consecutive draws of one section cost one query.
+    class GpuTimer
+    {
+    public:
+        static constexpr std::size_t FrameLatency = 2;
+
+        GpuTimer() = default;
+        ~GpuTimer();
+
+        GpuTimer(const GpuTimer &) = delete;
+        GpuTimer &operator=(const GpuTimer &) = delete;
+
+        void set_section_count(std::size_t count);
+
+        void begin(std::size_t section);
+        void end();
+
+        // Call once per frame after the last end(); reads back the older frame.
+        void end_frame();
+
+        // Milliseconds per section for the frame read back by the last
+        // end_frame(); all zero if that frame was dropped (see stale()).
+        std::span<const double> section_ms() const noexcept { return m_section_ms; }
+
+        // True if the last end_frame() dropped its frame.
+        bool stale() const noexcept { return m_stale; }
+
+        // Frames whose results were not ready in time.
+        std::uint64_t dropped_frames() const noexcept { return m_dropped; }
+
+        void release();
+
+    private:
+        struct Frame
+        {
+            std::vector<GLuint> queries; // pool, grows to the busiest frame
+            std::vector<std::uint32_t> sections;
+            std::size_t used = 0;
+        };
+
+        void collect(Frame &frame);
+
+        std::array<Frame, FrameLatency> m_frames;
+        std::size_t m_frame = 0;
+        int m_open = -1;
+
+        std::vector<double> m_section_ms;
+        std::uint64_t m_dropped = 0;
+        bool m_stale = false;
+    };
+}
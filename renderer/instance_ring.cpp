@@ -0,0 +1,211 @@
+#include "instance_ring.hpp"
+
+#include <stdexcept>
+
+#include "gl_extensions.hpp"
+
+namespace renderer
+{
+    InstanceRing::~InstanceRing()
+    {
+        release();
+    }
+
+    void InstanceRing::create(std::size_t region_bytes, Mode preferred)
+    {
+        release();
+
+        m_region_bytes = region_bytes;
+        m_region = 0;
+        m_head = 0;
+
+        const auto total = static_cast<GLsizeiptr>(region_bytes * RegionCount);
+
+        m_mode = preferred;
+        if (m_mode == Mode::Persistent && !gl_extensions().buffer_storage)
+        {
+            m_mode = Mode::Unsynchronized;
+        }
+
+        glGenBuffers(1, &m_buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+
+        if (m_mode == Mode::Persistent)
+        {
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            gl_extensions().BufferStorage(GL_ARRAY_BUFFER, total, nullptr, flags);
+
+            m_persistent = static_cast<unsigned char *>(glMapBufferRange(GL_ARRAY_BUFFER, 0, total, flags));
+            if (!m_persistent)
+            {
+                // Immutable storage can't be re-specified; start over with a mutable buffer.
+                glBindBuffer(GL_ARRAY_BUFFER, 0);
+                glDeleteBuffers(1, &m_buffer);
+                m_buffer = 0;
+                create(region_bytes, Mode::Unsynchronized);
+                return;
+            }
+        }
+        else
+        {
+            glBufferData(GL_ARRAY_BUFFER, total, nullptr, GL_STREAM_DRAW);
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void InstanceRing::release()
+    {
+        for (auto &fence : m_fences)
+        {
+            if (fence)
+            {
+                glDeleteSync(fence);
+                fence = nullptr;
+            }
+        }
+
+        if (m_buffer)
+        {
+            if (m_persistent || m_mapped)
+            {
+                glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+                glUnmapBuffer(GL_ARRAY_BUFFER);
+                glBindBuffer(GL_ARRAY_BUFFER, 0);
+            }
+            glDeleteBuffers(1, &m_buffer);
+            m_buffer = 0;
+        }
+
+        m_persistent = nullptr;
+        m_mapped = false;
+        m_head = 0;
+        m_region = 0;
+        m_region_fenced = false;
+    }
+
+    void *InstanceRing::map(std::size_t bytes, std::size_t &offset)
+    {
+        if (bytes > m_region_bytes)
+        {
+            throw std::runtime_error("InstanceRing: allocation larger than a region");
+        }
+
+        if (m_head + bytes > m_region_bytes)
+        {
+            advance();
+        }
+
+        offset = static_cast<std::size_t>(m_region) * m_region_bytes + m_head;
+        m_head += bytes;
+
+        if (m_mode == Mode::Persistent)
+        {
+            return m_persistent + offset;
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+        void *ptr = glMapBufferRange(
+            GL_ARRAY_BUFFER,
+            static_cast<GLintptr>(offset),
+            static_cast<GLsizeiptr>(bytes),
+            GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+
+        if (!ptr)
+        {
+            throw std::runtime_error("InstanceRing: glMapBufferRange failed");
+        }
+
+        m_mapped = true;
+        return ptr;
+    }
+
+    void InstanceRing::commit()
+    {
+        if (!m_mapped)
+        {
+            return;
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        m_mapped = false;
+    }
+
+    void InstanceRing::end_frame()
+    {
+        if (m_head == 0)
+        {
+            return;
+        }
+
+        fence_region();
+
+        // Force the next map() onto a fresh region.
+        m_head = m_region_bytes;
+    }
+
+    void InstanceRing::fence_region()
+    {
+        if (m_mode == Mode::Orphan || m_region_fenced)
+        {
+            return;
+        }
+
+        if (m_fences[m_region])
+        {
+            glDeleteSync(m_fences[m_region]);
+        }
+        m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        m_region_fenced = true;
+    }
+
+    void InstanceRing::advance()
+    {
+        // A region filled mid-frame still needs protecting before we move on.
+        if (m_head > 0)
+        {
+            fence_region();
+        }
+
+        m_region = (m_region + 1) % RegionCount;
+        m_head = 0;
+        m_region_fenced = false;
+
+        if (m_mode == Mode::Orphan)
+        {
+            if (m_region == 0)
+            {
+                glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+                glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(m_region_bytes * RegionCount), nullptr, GL_STREAM_DRAW);
+            }
+            return;
+        }
+
+        wait_region(m_region);
+    }
+
+    void InstanceRing::wait_region(int region)
+    {
+        GLsync fence = m_fences[region];
+        if (!fence)
+        {
+            return;
+        }
+
+        // Poll first so the counter only reflects real stalls.
+        GLenum status = glClientWaitSync(fence, 0, 0);
+        if (status == GL_TIMEOUT_EXPIRED)
+        {
+            ++m_fence_waits;
+
+            do
+            {
+                status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000'000ull);
+            } while (status == GL_TIMEOUT_EXPIRED);
+        }
+
+        glDeleteSync(fence);
+        m_fences[region] = nullptr;
+    }
+}
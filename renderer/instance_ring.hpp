@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <glad/gl.h>
+
+namespace renderer
+{
+    // Triple-buffered ring of streaming instance memory.
+    //
+    // The buffer is split into RegionCount regions; each frame writes into its own
+    // region and end_frame() fences it. Before a region is reused the CPU waits on
+    // that fence, so the GPU never reads memory that is being overwritten and the
+    // driver never has to stall or shadow-copy a buffer that is still in flight.
+    //
+    // Modes (best available is chosen by create()):
+    // - Persistent:     ARB_buffer_storage, mapped once (persistent + coherent)
+    // - Unsynchronized: glMapBufferRange(UNSYNCHRONIZED) per write, fence protected
+    // - Orphan:         orphans the whole buffer on wrap, no fences needed
+    class InstanceRing
+    {
+    public:
+        enum class Mode
+        {
+            Persistent,
+            Unsynchronized,
+            Orphan
+        };
+
+        static constexpr int RegionCount = 3;
+
+        InstanceRing() = default;
+        ~InstanceRing();
+
+        InstanceRing(const InstanceRing &) = delete;
+        InstanceRing &operator=(const InstanceRing &) = delete;
+
+        // Falls back from the preferred mode if the driver lacks support for it.
+        void create(std::size_t region_bytes, Mode preferred = Mode::Persistent);
+        void release();
+
+        // Reserves `bytes` (<= region_bytes()) in the current region and returns a
+        // write pointer; `offset` receives the byte offset inside buffer().
+        // The caller must call commit() before drawing from the range.
+        void *map(std::size_t bytes, std::size_t &offset);
+        void commit();
+
+        // Fences the current region; the next map() moves to the next region.
+        void end_frame();
+
+        // Bytes map() can still hand out before it moves to the next region.
+        std::size_t available() const noexcept { return m_region_bytes - m_head; }
+
+        GLuint buffer() const noexcept { return m_buffer; }
+        Mode mode() const noexcept { return m_mode; }
+        std::size_t region_bytes() const noexcept { return m_region_bytes; }
+
+        // Number of times map() had to block because the GPU still owned a region.
+        std::uint64_t fence_waits() const noexcept { return m_fence_waits; }
+
+    private:
+        void advance();
+        void fence_region();
+        void wait_region(int region);
+
+    private:
+        GLuint m_buffer{};
+        Mode m_mode = Mode::Persistent;
+
+        std::size_t m_region_bytes{};
+        int m_region{};
+        std::size_t m_head{};
+        bool m_region_fenced = false;
+
+        std::array<GLsync, RegionCount> m_fences{};
+
+        unsigned char *m_persistent{};
+        bool m_mapped = false;
+
+        std::uint64_t m_fence_waits{};
+    };
+}
@@ -0,0 +1,138 @@
+#include "render_queue.hpp"
+
+#include <array>
+#include <bit>
+#include <utility>
+
+#include "util/profiler.hpp"
+
+namespace renderer
+{
+    namespace sort_key
+    {
+        namespace
+        {
+            constexpr uint64_t YSortedBit = 1ull << 52;
+        }
+
+        uint32_t depth_bits(float depth) noexcept
+        {
+            // Flip negatives entirely and set the sign bit on positives so the
+            // unsigned order matches the float order.
+            const uint32_t bits = std::bit_cast<uint32_t>(depth);
+            return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+        }
+
+        uint64_t make(uint8_t layer, uint8_t pass, uint8_t shader, uint16_t material, float depth, LayerSort sort) noexcept
+        {
+            const bool front_to_back = pass == OpaquePass;
+            const uint8_t l = front_to_back ? static_cast<uint8_t>(0xFFu - layer) : layer;
+            const uint64_t d = front_to_back ? uint32_t(~depth_bits(depth)) : depth_bits(depth);
+
+            uint64_t key = (uint64_t(pass & 0x7u) << 61) | (uint64_t(l) << 53);
+
+            // Translucent draws blend in key order; depth must come first.
+            if (sort == LayerSort::YSorted || pass == TranslucentPass)
+            {
+                key |= YSortedBit | (d << 20) | (uint64_t(shader & 0xFu) << 16) | material;
+            }
+            else
+            {
+                key |= (uint64_t(shader & 0xFu) << 48) | (uint64_t(material) << 32) | d;
+            }
+
+            return key;
+        }
+
+        uint64_t state(uint64_t key) noexcept
+        {
+            return (key & YSortedBit) ? (key & ~(0xFFFFFFFFull << 20)) : (key & ~0xFFFFFFFFull);
+        }
+
+        uint8_t layer(uint64_t key) noexcept
+        {
+            const auto l = static_cast<uint8_t>(key >> 53);
+            return pass(key) == OpaquePass ? static_cast<uint8_t>(0xFFu - l) : l;
+        }
+
+        uint8_t pass(uint64_t key) noexcept
+        {
+            return static_cast<uint8_t>(key >> 61);
+        }
+
+        uint8_t shader(uint64_t key) noexcept
+        {
+            return static_cast<uint8_t>((key & YSortedBit) ? ((key >> 16) & 0xFu) : ((key >> 48) & 0xFu));
+        }
+
+        uint16_t material(uint64_t key) noexcept
+        {
+            return static_cast<uint16_t>((key & YSortedBit) ? key : (key >> 32));
+        }
+    }
+
+    void RenderQueue::reserve(std::size_t n)
+    {
+        m_entries.reserve(n);
+        m_scratch.reserve(n);
+    }
+
+    void RenderQueue::sort()
+    {
+        PROFILE_SCOPE("RenderQueue::sort");
+
+        const std::size_t n = m_entries.size();
+        if (n < 2)
+        {
+            return;
+        }
+
+        m_scratch.resize(n);
+
+        // One histogram pass for all 8 digits.
+        std::array<std::array<uint32_t, 256>, 8> counts{};
+        for (const Entry &e : m_entries)
+        {
+            for (int d = 0; d < 8; ++d)
+            {
+                ++counts[d][(e.key >> (d * 8)) & 0xFFu];
+            }
+        }
+
+        Entry *src = m_entries.data();
+        Entry *dst = m_scratch.data();
+
+        for (int d = 0; d < 8; ++d)
+        {
+            auto &count = counts[d];
+
+            // Every key shares this byte: the pass would be a plain copy.
+            if (count[(src[0].key >> (d * 8)) & 0xFFu] == n)
+            {
+                continue;
+            }
+
+            uint32_t sum = 0;
+            for (auto &c : count)
+            {
+                const uint32_t c0 = c;
+                c = sum;
+                sum += c0;
+            }
+
+            const int shift = d * 8;
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                const Entry &e = src[i];
+                dst[count[(e.key >> shift) & 0xFFu]++] = e;
+            }
+
+            std::swap(src, dst);
+        }
+
+        if (src != m_entries.data())
+        {
+            m_entries.swap(m_scratch);
+        }
+    }
+}
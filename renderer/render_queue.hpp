@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace renderer
+{
+    // How draws inside one layer are ordered.
+    // - Batched: by state first, y-depth within a state (fewest draw calls)
+    // - YSorted: by y-depth first, state within a depth (correct overlap for
+    //   top-down entities; draws break whenever the texture changes)
+    enum class LayerSort : uint8_t
+    {
+        Batched,
+        YSorted
+    };
+
+    // 64-bit sort key layout (most significant first):
+    //   [63..61] pass
+    //   [60..53] layer
+    //   [52]     1 = YSorted layout (constant per layer and pass, so it never reorders)
+    //   Batched: [51..48] shader  [47..32] material  [31..0] depth
+    //   YSorted: [51..20] depth   [19..16] shader    [15..0] material
+    // Depth is the float y-depth mapped to an order-preserving uint32.
+    //
+    // OpaquePass keys store layer and depth inverted, so that pass runs front
+    // to back (the depth buffer resolves overlap and early-Z rejects what is
+    // hidden); TranslucentPass runs back to front, after every opaque draw.
+    // Blending is order dependent, so TranslucentPass keys always use the
+    // YSorted layout: LayerSort::Batched only regroups opaque draws.
+    namespace sort_key
+    {
+        constexpr uint8_t OpaquePass = 0;
+        constexpr uint8_t TranslucentPass = 1;
+
+        uint64_t make(uint8_t layer, uint8_t pass, uint8_t shader, uint16_t material, float depth, LayerSort sort) noexcept;
+
+        // Key with the depth bits cleared: equal values can share a draw.
+        uint64_t state(uint64_t key) noexcept;
+
+        uint8_t layer(uint64_t key) noexcept;
+        uint8_t pass(uint64_t key) noexcept;
+        uint8_t shader(uint64_t key) noexcept;
+        uint16_t material(uint64_t key) noexcept;
+
+        uint32_t depth_bits(float depth) noexcept;
+    }
+
+    // Flat list of (key, payload) pairs ordered with an LSD radix sort.
+    // The sort is stable, so equal keys keep submission order and the result
+    // is deterministic frame to frame. Capacity is kept across clear().
+    class RenderQueue
+    {
+    public:
+        struct Entry
+        {
+            uint64_t key;
+            uint32_t payload;
+        };
+
+        void clear() noexcept { m_entries.clear(); }
+        void reserve(std::size_t n);
+
+        void push(uint64_t key, uint32_t payload) { m_entries.push_back(Entry{key, payload}); }
+
+        void sort();
+
+        std::size_t size() const noexcept { return m_entries.size(); }
+        bool empty() const noexcept { return m_entries.empty(); }
+        std::span<const Entry> entries() const noexcept { return m_entries; }
+
+    private:
+        std::vector<Entry> m_entries;
+        std::vector<Entry> m_scratch;
+    };
+}
@@ -0,0 +1,134 @@
+#include "sequence_table.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+#include "util/sheet_array.hpp"
+
+namespace renderer
+{
+    namespace
+    {
+        void upload_buffer_texture(GLuint &buffer, GLuint &texture, GLenum format, const void *data, size_t bytes)
+        {
+            if (buffer == 0)
+            {
+                glGenBuffers(1, &buffer);
+                glGenTextures(1, &texture);
+            }
+
+            glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+            glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(bytes), data, GL_STATIC_DRAW);
+
+            glBindTexture(GL_TEXTURE_BUFFER, texture);
+            glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+
+            glBindTexture(GL_TEXTURE_BUFFER, 0);
+            glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        }
+
+        void delete_buffer_texture(GLuint &buffer, GLuint &texture)
+        {
+            if (texture)
+            {
+                glDeleteTextures(1, &texture);
+                texture = 0;
+            }
+            if (buffer)
+            {
+                glDeleteBuffers(1, &buffer);
+                buffer = 0;
+            }
+        }
+    }
+
+    SequenceTable::~SequenceTable()
+    {
+        release();
+    }
+
+    uint16_t SequenceTable::add(const util::SpriteSheet &sheet, const util::FrameSequence &sequence)
+    {
+        const size_t id = m_sequences.size() / 4;
+        if (id > 0xFFFF)
+        {
+            throw std::runtime_error("SequenceTable: too many sequences");
+        }
+
+        const uint32_t base = sheet.array() ? static_cast<uint32_t>(sheet.array_first_layer()) : 0u;
+        const auto first = static_cast<float>(m_frames.size());
+
+        for (unsigned int frame : sequence.frames)
+        {
+            m_frames.push_back(base + frame);
+        }
+
+        m_sequences.push_back(first);
+        m_sequences.push_back(static_cast<float>(sequence.frames.size()));
+        m_sequences.push_back(static_cast<float>(sequence.seconds_per_frame));
+        m_sequences.push_back(0.0f);
+
+        const double loop = sequence.seconds_per_frame * static_cast<double>(sequence.frames.size());
+        if (loop > 0.0)
+        {
+            const auto max_ms = static_cast<uint64_t>(MaxPeriod * 1000.0);
+            const auto loop_ms = std::max<uint64_t>(1, static_cast<uint64_t>(std::llround(loop * 1000.0)));
+
+            if (!m_has_period)
+            {
+                m_period_ms = std::min(loop_ms, max_ms);
+                m_has_period = true;
+            }
+            else if (m_period_ms < max_ms)
+            {
+                // Both operands are at most max_ms, so this can't overflow.
+                const uint64_t lcm = m_period_ms / std::gcd(m_period_ms, loop_ms) * loop_ms;
+                m_period_ms = std::min(lcm, max_ms);
+            }
+        }
+
+        return static_cast<uint16_t>(id);
+    }
+
+    void SequenceTable::upload()
+    {
+        // Buffer textures can't be empty; upload one dummy entry so binding is always valid.
+        static const uint32_t no_frames[1] = {0};
+        static const float no_sequences[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+        if (m_frames.empty())
+        {
+            upload_buffer_texture(m_frames_buffer, m_frames_texture, GL_R32UI, no_frames, sizeof(no_frames));
+        }
+        else
+        {
+            upload_buffer_texture(m_frames_buffer, m_frames_texture, GL_R32UI, m_frames.data(), m_frames.size() * sizeof(uint32_t));
+        }
+
+        if (m_sequences.empty())
+        {
+            upload_buffer_texture(m_sequences_buffer, m_sequences_texture, GL_RGBA32F, no_sequences, sizeof(no_sequences));
+        }
+        else
+        {
+            upload_buffer_texture(m_sequences_buffer, m_sequences_texture, GL_RGBA32F, m_sequences.data(), m_sequences.size() * sizeof(float));
+        }
+    }
+
+    void SequenceTable::bind(GLuint frames_slot, GLuint sequences_slot) const
+    {
+        glActiveTexture(GL_TEXTURE0 + frames_slot);
+        glBindTexture(GL_TEXTURE_BUFFER, m_frames_texture);
+
+        glActiveTexture(GL_TEXTURE0 + sequences_slot);
+        glBindTexture(GL_TEXTURE_BUFFER, m_sequences_texture);
+    }
+
+    void SequenceTable::release()
+    {
+        delete_buffer_texture(m_frames_buffer, m_frames_texture);
+        delete_buffer_texture(m_sequences_buffer, m_sequences_texture);
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glad/gl.h>
+
+#include "util/animation_library.hpp"
+#include "util/sprite_sheet.hpp"
+
+namespace renderer
+{
+    // GPU-side copy of FrameSequence data so the vertex shader can pick the
+    // current frame from a time uniform:
+    // - frames:    usamplerBuffer, every sequence's frame list back to back
+    // - sequences: samplerBuffer, one (first_frame, frame_count, seconds_per_frame, 0) per ID
+    //
+    // Frames are stored already resolved for the sheet they belong to (array
+    // layer when the sheet was packed into a texture array), so register
+    // sequences after util::build_sheet_arrays.
+    //
+    // The shader's time uniform is a float, which loses sub-frame precision
+    // after a few hours of absolute seconds. period() is a duration every
+    // sequence loops over a whole number of times, so the caller can wrap
+    // its clock (in double) before narrowing it.
+    class SequenceTable
+    {
+    public:
+        // Longest period(); also used when loop lengths share no shorter one.
+        // Float time keeps ~0.25 ms resolution up to here.
+        static constexpr double MaxPeriod = 3600.0;
+        SequenceTable() = default;
+        ~SequenceTable();
+
+        SequenceTable(const SequenceTable &) = delete;
+        SequenceTable &operator=(const SequenceTable &) = delete;
+
+        // Returns the sequence ID to store in an animated instance's frame field.
+        uint16_t add(const util::SpriteSheet &sheet, const util::FrameSequence &sequence);
+
+        // Uploads everything added so far.
+        void upload();
+
+        void bind(GLuint frames_slot, GLuint sequences_slot) const;
+
+        // GL_TEXTURE_BUFFER names, for callers that track bindings themselves.
+        GLuint frames_texture() const noexcept { return m_frames_texture; }
+        GLuint sequences_texture() const noexcept { return m_sequences_texture; }
+
+        // Least common multiple of the loop lengths added so far, in whole
+        // milliseconds, or MaxPeriod if that would be longer. Loops that
+        // aren't whole milliseconds skip by a fraction of a frame per wrap.
+        double period() const noexcept { return static_cast<double>(m_period_ms) * 1e-3; }
+
+        int size() const noexcept { return static_cast<int>(m_sequences.size() / 4); }
+        void release();
+
+    private:
+        std::vector<uint32_t> m_frames;
+        std::vector<float> m_sequences;
+        uint64_t m_period_ms = static_cast<uint64_t>(MaxPeriod * 1000.0);
+        bool m_has_period = false;
+
+        GLuint m_frames_buffer{};
+        GLuint m_frames_texture{};
+        GLuint m_sequences_buffer{};
+        GLuint m_sequences_texture{};
+    };
+}
@@ -1,5 +1,6 @@
 #include "shader.hpp"
 
+#include <cstring>
 #include <fstream>
 #include <sstream>
 #include <stdexcept>
@@ -21,6 +22,14 @@ namespace renderer
 
         glDeleteShader(vs);
         glDeleteShader(fs);
+
+        reflect_uniforms();
+    }
+
+    Shader::Shader(GLuint program)
+        : m_program(program)
+    {
+        reflect_uniforms();
     }
 
     Shader::~Shader()
@@ -29,7 +38,8 @@ namespace renderer
     }
 
     Shader::Shader(Shader &&other) noexcept
-        : m_program(std::exchange(other.m_program, 0))
+        : m_program(std::exchange(other.m_program, 0)),
+          m_uniforms(std::move(other.m_uniforms))
     {
     }
 
@@ -39,6 +49,7 @@ namespace renderer
         {
             release();
             m_program = std::exchange(other.m_program, 0);
+            m_uniforms = std::move(other.m_uniforms);
         }
         return *this;
     }
@@ -48,45 +59,125 @@ namespace renderer
         glUseProgram(m_program);
     }
 
-    void Shader::set_int(const char *name, int value) const
+    bool Shader::set(Uniform<int> u, int value)
     {
-        const auto loc = glGetUniformLocation(m_program, name);
-        if (loc >= 0)
+        if (!u.valid() || !store(u.slot, &value, sizeof(value)))
         {
-            glUniform1i(loc, value);
+            return false;
         }
+        glUniform1i(u.location, value);
+        return true;
     }
 
-    void Shader::set_float(const std::string &name, float v) const
+    bool Shader::set(Uniform<float> u, float value)
     {
-        const auto loc = get_uniform_location(name);
-        if (loc >= 0)
+        if (!u.valid() || !store(u.slot, &value, sizeof(value)))
         {
-            glUniform1f(loc, v);
+            return false;
         }
+        glUniform1f(u.location, value);
+        return true;
     }
 
-    void Shader::set_vec4(const std::string &name, const glm::vec4 &v) const
+    bool Shader::set(Uniform<glm::vec4> u, const glm::vec4 &value)
     {
-        const auto loc = get_uniform_location(name);
-        if (loc >= 0)
+        if (!u.valid() || !store(u.slot, &value, sizeof(value)))
         {
-            glUniform4f(loc, v.x, v.y, v.z, v.w);
+            return false;
         }
+        glUniform4f(u.location, value.x, value.y, value.z, value.w);
+        return true;
     }
-    
-    void Shader::set_mat4(const char *name, const glm::mat4 &value) const
+
+    bool Shader::set(Uniform<glm::mat4> u, const glm::mat4 &value)
     {
-        const auto loc = glGetUniformLocation(m_program, name);
-        if (loc >= 0)
+        if (!u.valid() || !store(u.slot, &value, sizeof(value)))
         {
-            glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(value));
+            return false;
         }
+        glUniformMatrix4fv(u.location, 1, GL_FALSE, glm::value_ptr(value));
+        return true;
     }
 
-    GLint Shader::get_uniform_location(const std::string &name) const
+    void Shader::set_int(const char *name, int value)
     {
-        return glGetUniformLocation(m_program, name.c_str());
+        set(uniform<int>(name), value);
+    }
+
+    void Shader::set_float(const std::string &name, float v)
+    {
+        set(uniform<float>(name), v);
+    }
+
+    void Shader::set_vec4(const std::string &name, const glm::vec4 &v)
+    {
+        set(uniform<glm::vec4>(name), v);
+    }
+
+    void Shader::set_mat4(const char *name, const glm::mat4 &value)
+    {
+        set(uniform<glm::mat4>(name), value);
+    }
+
+    void Shader::reflect_uniforms()
+    {
+        m_uniforms.clear();
+
+        GLint count = 0;
+        GLint max_len = 0;
+        glGetProgramiv(m_program, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(m_program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_len);
+
+        std::string name(static_cast<size_t>(max_len > 1 ? max_len : 1), '\0');
+
+        for (GLint i = 0; i < count; ++i)
+        {
+            GLsizei len = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(m_program, static_cast<GLuint>(i), max_len, &len, &size, &type, name.data());
+
+            std::string uniform_name(name.data(), static_cast<size_t>(len));
+
+            // Arrays reflect as "name[0]"; address them by their base name.
+            if (const auto bracket = uniform_name.find('['); bracket != std::string::npos)
+            {
+                uniform_name.resize(bracket);
+            }
+
+            const GLint location = glGetUniformLocation(m_program, uniform_name.c_str());
+            if (location < 0)
+            {
+                continue; // uniform block members have no location
+            }
+
+            m_uniforms.push_back(UniformSlot{.name = std::move(uniform_name), .location = location});
+        }
+    }
+
+    int Shader::find_uniform(std::string_view name) const
+    {
+        for (size_t i = 0; i < m_uniforms.size(); ++i)
+        {
+            if (m_uniforms[i].name == name)
+            {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    bool Shader::store(int slot, const void *value, size_t size)
+    {
+        auto &u = m_uniforms[static_cast<size_t>(slot)];
+        if (u.has_value && std::memcmp(u.value.data(), value, size) == 0)
+        {
+            return false;
+        }
+
+        std::memcpy(u.value.data(), value, size);
+        u.has_value = true;
+        return true;
     }
 
     std::string Shader::read_file(const std::string &path)
@@ -164,5 +255,6 @@ namespace renderer
             glDeleteProgram(m_program);
             m_program = 0;
         }
+        m_uniforms.clear();
     }
 }
@@ -1,7 +1,10 @@
 // shader.hpp
 #pragma once
 
+#include <array>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include <glad/gl.h>
 #include <glm/mat4x4.hpp>
@@ -9,14 +12,30 @@
 
 namespace renderer
 {
+    // Typed handle to a uniform reflected at link time.
+    // Invalid (location -1) when the uniform is absent or optimised out;
+    // setting an invalid handle is a no-op.
+    template <typename T>
+    struct Uniform
+    {
+        int slot = -1;
+        GLint location = -1;
+
+        bool valid() const noexcept { return location >= 0; }
+    };
+
     // Minimal shader helper:
     // - loads vertex/fragment shader from files
     // - compiles + links
-    // - sets uniforms
+    // - reflects active uniforms once and caches their locations and values
+    // - sets uniforms (redundant uploads of an unchanged value are skipped)
     class Shader
     {
     public:
         Shader(const std::string &vertex_path, const std::string &fragment_path);
+
+        // Adopts an already linked program (see ShaderCache).
+        explicit Shader(GLuint program);
         ~Shader();
 
         Shader(const Shader &) = delete;
@@ -28,19 +47,49 @@ namespace renderer
         void use() const;
         GLuint id() const noexcept { return m_program; }
 
-        void set_int(const char *name, int value) const;
-        void set_float(const std::string &name, float v) const;
-        void set_vec4(const std::string &name, const glm::vec4 &v) const;
-        void set_mat4(const char *name, const glm::mat4 &value) const;
+        template <typename T>
+        Uniform<T> uniform(std::string_view name) const
+        {
+            const int slot = find_uniform(name);
+            return Uniform<T>{slot, slot >= 0 ? m_uniforms[static_cast<size_t>(slot)].location : -1};
+        }
+
+        // Program must be current. Returns false when the upload was skipped
+        // because the uniform already holds `value` (or the handle is invalid).
+        bool set(Uniform<int> u, int value);
+        bool set(Uniform<float> u, float value);
+        bool set(Uniform<glm::vec4> u, const glm::vec4 &value);
+        bool set(Uniform<glm::mat4> u, const glm::mat4 &value);
+
+        void set_int(const char *name, int value);
+        void set_float(const std::string &name, float v);
+        void set_vec4(const std::string &name, const glm::vec4 &v);
+        void set_mat4(const char *name, const glm::mat4 &value);
         void release();
 
+        static std::string read_file(const std::string &path);
+
     private:
+        struct UniformSlot
+        {
+            std::string name;
+            GLint location = -1;
+
+            // Last uploaded value (raw bytes, up to a mat4).
+            std::array<unsigned char, sizeof(glm::mat4)> value{};
+            bool has_value = false;
+        };
+
         GLuint m_program{};
+        std::vector<UniformSlot> m_uniforms;
 
-        static std::string read_file(const std::string &path);
         static GLuint compile_stage(GLenum type, const std::string &source, const std::string &debug_name);
         static GLuint link_program(GLuint vs, GLuint fs);
 
-        GLint get_uniform_location(const std::string &name) const;
+        void reflect_uniforms();
+        int find_uniform(std::string_view name) const;
+
+        // Records `value` for the slot; false when it is unchanged.
+        bool store(int slot, const void *value, size_t size);
     };
 }
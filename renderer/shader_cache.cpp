@@ -0,0 +1,306 @@
+#include "shader_cache.hpp"
+
+#include <cstdint>
+#include <cstdio> // std::snprintf
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+#include "gl_extensions.hpp"
+#include "util/profiler.hpp"
+
+namespace renderer
+{
+    namespace
+    {
+        // "SPBC" + format + binary
+        constexpr std::uint32_t BinaryMagic = 0x43425053u;
+
+        std::string gl_string(GLenum name)
+        {
+            const auto *s = reinterpret_cast<const char *>(glGetString(name));
+            return s ? s : "";
+        }
+
+        // Inserts the permutation's #defines after the #version line (which
+        // must stay first in GLSL).
+        std::string inject_defines(const std::string &source, const std::vector<std::string> &defines)
+        {
+            if (defines.empty())
+            {
+                return source;
+            }
+
+            std::string block;
+            for (const auto &define : defines)
+            {
+                block += "#define " + define + "\n";
+            }
+
+            std::size_t at = 0;
+            if (source.compare(0, 8, "#version") == 0)
+            {
+                const auto eol = source.find('\n');
+                at = eol == std::string::npos ? source.size() : eol + 1;
+            }
+
+            std::string out = source;
+            out.insert(at, block);
+            return out;
+        }
+
+        // FNV-1a, 64 bit.
+        std::uint64_t hash_bytes(std::uint64_t h, const std::string &bytes) noexcept
+        {
+            for (unsigned char c : bytes)
+            {
+                h ^= c;
+                h *= 0x100000001b3ull;
+            }
+            // Separator so ("ab", "c") and ("a", "bc") differ.
+            h ^= 0xFF;
+            h *= 0x100000001b3ull;
+            return h;
+        }
+
+        std::string shader_log(GLuint shader)
+        {
+            GLint len = 0;
+            glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &len);
+
+            std::string log(static_cast<size_t>(len > 1 ? len : 1), '\0');
+            glGetShaderInfoLog(shader, len, nullptr, log.data());
+            return log;
+        }
+
+        std::string program_log(GLuint program)
+        {
+            GLint len = 0;
+            glGetProgramiv(program, GL_INFO_LOG_LENGTH, &len);
+
+            std::string log(static_cast<size_t>(len > 1 ? len : 1), '\0');
+            glGetProgramInfoLog(program, len, nullptr, log.data());
+            return log;
+        }
+
+        GLuint start_stage(GLenum type, const std::string &source)
+        {
+            const auto shader = glCreateShader(type);
+
+            const char *src = source.c_str();
+            glShaderSource(shader, 1, &src, nullptr);
+            glCompileShader(shader);
+            return shader;
+        }
+    }
+
+    ShaderCache::ShaderCache(std::string directory)
+        : m_directory(std::move(directory)),
+          m_driver(gl_string(GL_VENDOR) + "|" + gl_string(GL_RENDERER) + "|" + gl_string(GL_VERSION))
+    {
+    }
+
+    std::vector<Shader> ShaderCache::build(std::span<const ShaderDesc> descs)
+    {
+        PROFILE_SCOPE("ShaderCache::build");
+
+        const auto &ext = gl_extensions();
+        if (ext.parallel_shader_compile)
+        {
+            ext.MaxShaderCompilerThreads(0xFFFFFFFFu); // driver's choice
+        }
+
+        std::vector<GLuint> programs(descs.size(), 0);
+        std::vector<Pending> pending;
+
+        // Pass 1: load what we can, kick off compiles for the rest.
+        for (std::size_t i = 0; i < descs.size(); ++i)
+        {
+            const auto &desc = descs[i];
+            const auto vs_src = inject_defines(Shader::read_file(desc.vertex_path), desc.defines);
+            const auto fs_src = inject_defines(Shader::read_file(desc.fragment_path), desc.defines);
+
+            std::uint64_t h = 0xcbf29ce484222325ull;
+            h = hash_bytes(h, m_driver);
+            h = hash_bytes(h, vs_src);
+            h = hash_bytes(h, fs_src);
+
+            char key[17];
+            std::snprintf(key, sizeof(key), "%016llx", static_cast<unsigned long long>(h));
+
+            if (const GLuint program = load_binary(key))
+            {
+                programs[i] = program;
+                ++m_stats.binary_hits;
+                continue;
+            }
+
+            Pending p{.index = i, .key = key, .debug_name = desc.vertex_path + " + " + desc.fragment_path};
+            for (const auto &define : desc.defines)
+            {
+                p.debug_name += " -D" + define;
+            }
+
+            p.vs = start_stage(GL_VERTEX_SHADER, vs_src);
+            p.fs = start_stage(GL_FRAGMENT_SHADER, fs_src);
+            pending.push_back(std::move(p));
+        }
+
+        // Pass 2: link everything without waiting on compile status.
+        for (auto &p : pending)
+        {
+            p.program = glCreateProgram();
+            if (ext.program_binary)
+            {
+                ext.ProgramParameteri(p.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+            }
+            glAttachShader(p.program, p.vs);
+            glAttachShader(p.program, p.fs);
+            glLinkProgram(p.program);
+        }
+
+        // Pass 3: the first status query per program is where we block.
+        for (std::size_t i = 0; i < pending.size(); ++i)
+        {
+            try
+            {
+                finish(pending[i]);
+            }
+            catch (...)
+            {
+                for (auto &p : pending)
+                {
+                    glDeleteShader(p.vs);
+                    glDeleteShader(p.fs);
+                    glDeleteProgram(p.program);
+                }
+                for (GLuint program : programs)
+                {
+                    glDeleteProgram(program);
+                }
+                throw;
+            }
+
+            programs[pending[i].index] = std::exchange(pending[i].program, 0);
+            ++m_stats.compiled;
+        }
+
+        std::vector<Shader> shaders;
+        shaders.reserve(programs.size());
+        for (GLuint program : programs)
+        {
+            shaders.emplace_back(program);
+        }
+        return shaders;
+    }
+
+    void ShaderCache::finish(Pending &p)
+    {
+        GLint ok = 0;
+        glGetProgramiv(p.program, GL_LINK_STATUS, &ok);
+
+        if (!ok)
+        {
+            std::string log;
+            for (GLuint stage : {p.vs, p.fs})
+            {
+                GLint compiled = 0;
+                glGetShaderiv(stage, GL_COMPILE_STATUS, &compiled);
+                if (!compiled)
+                {
+                    log += shader_log(stage);
+                }
+            }
+
+            if (log.empty())
+            {
+                throw std::runtime_error("Program link failed (" + p.debug_name + "):\n" + program_log(p.program));
+            }
+            throw std::runtime_error("Shader compile failed (" + p.debug_name + "):\n" + log);
+        }
+
+        glDetachShader(p.program, p.vs);
+        glDetachShader(p.program, p.fs);
+        glDeleteShader(std::exchange(p.vs, 0));
+        glDeleteShader(std::exchange(p.fs, 0));
+
+        store_binary(p.key, p.program);
+    }
+
+    GLuint ShaderCache::load_binary(const std::string &key) const
+    {
+        const auto &ext = gl_extensions();
+        if (!ext.program_binary)
+        {
+            return 0;
+        }
+
+        std::ifstream file(m_directory + "/" + key + ".bin", std::ios::binary);
+        if (!file)
+        {
+            return 0;
+        }
+
+        std::uint32_t header[2] = {};
+        if (!file.read(reinterpret_cast<char *>(header), sizeof(header)) || header[0] != BinaryMagic)
+        {
+            return 0;
+        }
+
+        const std::vector<char> binary(std::istreambuf_iterator<char>(file), {});
+        if (binary.empty())
+        {
+            return 0;
+        }
+
+        const GLuint program = glCreateProgram();
+        ext.ProgramBinary(program, static_cast<GLenum>(header[1]), binary.data(), static_cast<GLsizei>(binary.size()));
+
+        GLint ok = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &ok);
+        if (!ok)
+        {
+            // Stale or foreign binary; fall back to compiling.
+            glDeleteProgram(program);
+            return 0;
+        }
+
+        return program;
+    }
+
+    void ShaderCache::store_binary(const std::string &key, GLuint program) const
+    {
+        const auto &ext = gl_extensions();
+        if (!ext.program_binary)
+        {
+            return;
+        }
+
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0)
+        {
+            return;
+        }
+
+        std::vector<char> binary(static_cast<size_t>(length));
+        GLenum format = 0;
+        ext.GetProgramBinary(program, length, nullptr, &format, binary.data());
+
+        // The cache is an optimisation only; failing to write it is not an error.
+        std::error_code ec;
+        std::filesystem::create_directories(m_directory, ec);
+
+        std::ofstream file(m_directory + "/" + key + ".bin", std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            return;
+        }
+
+        const std::uint32_t header[2] = {BinaryMagic, static_cast<std::uint32_t>(format)};
+        file.write(reinterpret_cast<const char *>(header), sizeof(header));
+        file.write(binary.data(), static_cast<std::streamsize>(binary.size()));
+    }
+}
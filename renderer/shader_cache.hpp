@@ -0,0 +1,69 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+
+#include <glad/gl.h>
+
+#include "shader.hpp"
+
+namespace renderer
+{
+    // One program permutation: the two source files plus the #defines that
+    // are injected right after their #version line.
+    struct ShaderDesc
+    {
+        std::string vertex_path;
+        std::string fragment_path;
+
+        // "NAME" or "NAME VALUE"
+        std::vector<std::string> defines;
+    };
+
+    // Builds shader programs, reusing linked binaries from disk when possible.
+    //
+    // - Every permutation's stages are compiled and linked before any status is
+    //   queried, so drivers with KHR_parallel_shader_compile build them concurrently.
+    // - Linked programs are stored with glGetProgramBinary under a key hashed from
+    //   the preprocessed sources and the driver strings; a warm start loads them
+    //   with glProgramBinary and never invokes the GLSL compiler.
+    // - A binary the driver rejects (e.g. after a driver update) is recompiled
+    //   and overwritten.
+    class ShaderCache
+    {
+    public:
+        struct Stats
+        {
+            int binary_hits = 0;
+            int compiled = 0;
+        };
+
+        // Requires load_gl_extensions(); without ARB_get_program_binary it only compiles.
+        explicit ShaderCache(std::string directory = "cache/shaders");
+
+        // Throws std::runtime_error on compile or link errors.
+        std::vector<Shader> build(std::span<const ShaderDesc> descs);
+
+        const Stats &stats() const noexcept { return m_stats; }
+
+    private:
+        struct Pending
+        {
+            std::size_t index = 0;
+            std::string key;
+            std::string debug_name;
+            GLuint vs = 0;
+            GLuint fs = 0;
+            GLuint program = 0;
+        };
+
+        GLuint load_binary(const std::string &key) const;
+        void store_binary(const std::string &key, GLuint program) const;
+        void finish(Pending &pending);
+
+        std::string m_directory;
+        std::string m_driver;
+        Stats m_stats;
+    };
+}
@@ -1,21 +1,133 @@
 #include "sprite_renderer.hpp"
 
 #include <algorithm> // std::min
+#include <cmath>     // std::lround, std::fmod
 #include <cstddef>   // offsetof
 #include <stdexcept>
+#include <utility>
+
+#include "gl_extensions.hpp"
+#include "shader_cache.hpp"
+#include "static_sprite_batch.hpp"
+#include "util/profiler.hpp"
 
 namespace renderer
 {
-    SpriteRenderer::SpriteRenderer()
-        : m_sprite_shader("assets/shaders/sprite.vert", "assets/shaders/sprite.frag"), m_font_shader("assets/shaders/sprite.vert", "assets/shaders/font.frag")
+    namespace
+    {
+        // 12.4 fixed point, clamped to the representable range.
+        uint16_t quantize_size(float px) noexcept
+        {
+            const long q = std::lround(px * 16.0f);
+            return static_cast<uint16_t>(std::clamp<long>(q, 0, 0xFFFF));
+        }
+
+        // 12-bit fraction of one animation loop.
+        uint16_t quantize_phase(float phase) noexcept
+        {
+            const float f = phase - std::floor(phase);
+            return static_cast<uint16_t>(std::min(4095L, std::lround(f * 4096.0f)));
+        }
+
+        // Texture units shared by every sprite shader.
+        constexpr GLuint TextureUnit = 0;
+        constexpr GLuint FrameTableUnit = 1;
+        constexpr GLuint SequenceFramesUnit = 2;
+        constexpr GLuint SequencesUnit = 3;
+        constexpr GLuint ShadowUnit = 4;
+        constexpr GLuint MaskUnit = 5;
+        constexpr GLuint TrimTableUnit = 6;
+    }
+
+    GpuSpriteInstance pack_instance(const util::SpriteSheet &sheet, const SpriteInstance &instance) noexcept
+    {
+        GpuSpriteInstance packed{
+            .pos = instance.pos,
+            .size = {quantize_size(instance.size.x), quantize_size(instance.size.y)},
+            .frame = static_cast<uint16_t>(instance.frame_index),
+            .flags = static_cast<uint16_t>(instance.flags & SpriteFlagBits),
+        };
+
+        if (instance.flags & SpriteAnimated)
+        {
+            // Sequence frames are already resolved to array layers by SequenceTable.
+            packed.flags |= static_cast<uint16_t>(quantize_phase(instance.phase) << SpritePhaseShift);
+        }
+        else if (sheet.array())
+        {
+            packed.frame = static_cast<uint16_t>(packed.frame + sheet.array_first_layer());
+        }
+
+        return packed;
+    }
+
+    std::vector<Shader> SpriteRenderer::build_shaders()
+    {
+        const std::string vert = "assets/shaders/sprite.vert";
+        const std::string frag = "assets/shaders/sprite.frag";
+
+        // Indexed by ShaderSlot.
+        const ShaderDesc descs[ShaderCount] = {
+            {vert, frag, {}},
+            {vert, frag, {"SPRITE_ARRAY"}},
+            {vert, "assets/shaders/font.frag", {}},
+            {vert, frag, {"NIGHT_COMPOSITE", "HAS_SHADOW"}},
+            {vert, frag, {"NIGHT_COMPOSITE", "HAS_MASK"}},
+            {vert, frag, {"NIGHT_COMPOSITE", "HAS_SHADOW", "HAS_MASK"}},
+            {vert, frag, {"NIGHT_COMPOSITE", "SPRITE_ARRAY"}},
+            {vert, frag, {"ALPHA_TEST"}},
+            {vert, frag, {"SPRITE_ARRAY", "ALPHA_TEST"}},
+        };
+
+        ShaderCache cache;
+        return cache.build(descs);
+    }
+
+    SpriteRenderer::SpriteRenderer(InstanceRing::Mode stream_mode, DrawBackend backend)
+        : SpriteRenderer(stream_mode, backend, build_shaders())
+    {
+    }
+
+    SpriteRenderer::SpriteRenderer(InstanceRing::Mode stream_mode, DrawBackend backend, std::vector<Shader> shaders)
+        : m_shaders(std::move(shaders))
     {
-        create_buffers();
+        create_buffers(stream_mode);
 
-        m_sprite_shader.use();
-        m_sprite_shader.set_int("u_texture", 0);
+        if (backend == DrawBackend::MultiDrawIndirect && gl_extensions().multi_draw_indirect)
+        {
+            m_backend = DrawBackend::MultiDrawIndirect;
+            glGenBuffers(1, &m_indirect_buffer);
+        }
 
-        m_font_shader.use();
-        m_font_shader.set_int("u_texture", 0);
+        // Every sampler needs its own unit, even in shaders that don't animate,
+        // otherwise mismatched sampler types would share unit 0.
+        for (Shader &shader : m_shaders)
+        {
+            shader.use();
+            shader.set_int("u_texture", TextureUnit);
+            shader.set_int("u_uv_table", FrameTableUnit);
+            shader.set_int("u_layer_table", FrameTableUnit);
+            shader.set_int("u_frames", SequenceFramesUnit);
+            shader.set_int("u_sequences", SequencesUnit);
+            shader.set_int("u_shadow_texture", ShadowUnit);
+            shader.set_int("u_mask_texture", MaskUnit);
+            shader.set_int("u_trim_table", TrimTableUnit);
+        }
+
+        for (uint8_t slot = 0; slot < ShaderCount; ++slot)
+        {
+            const Shader &shader = shader_for(slot);
+            m_uniforms[slot] = ShaderUniforms{
+                .proj = shader.uniform<glm::mat4>("u_proj"),
+                .time = shader.uniform<float>("u_time"),
+                .color = shader.uniform<glm::vec4>("u_color"),
+                .pass = shader.uniform<int>("u_pass"),
+                .layer = shader.uniform<float>("u_layer"),
+            };
+        }
+
+        // Valid (empty) tables until the application registers sequences.
+        m_sequences.upload();
 
         glUseProgram(0);
     }
@@ -29,7 +141,142 @@ namespace renderer
     {
         m_proj = proj;
         m_batch_type = type;
-        m_buckets.clear();
+        ++m_frame_stats.batches;
+        m_queue.clear();
+        m_instances.clear();
+        m_static_draws.clear();
+        m_glyph_runs.clear();
+    }
+
+    uint16_t SpriteRenderer::material_for(util::SpriteSheet &sheet)
+    {
+        const auto it = m_sheet_materials.find(&sheet);
+        if (it != m_sheet_materials.end())
+        {
+            return it->second;
+        }
+
+        // First time this sheet is seen: resolve once and remember it.
+        const uint16_t id = sheet.array()
+                                ? material_for(*sheet.array())
+                                : add_material(Material{.sheet = &sheet});
+
+        m_sheet_materials.emplace(&sheet, id);
+        return id;
+    }
+
+    uint16_t SpriteRenderer::material_for(const util::SheetArray &array)
+    {
+        for (size_t i = 0; i < m_materials.size(); ++i)
+        {
+            if (m_materials[i].array == &array)
+            {
+                return static_cast<uint16_t>(i);
+            }
+        }
+
+        return add_material(Material{.array = &array});
+    }
+
+    uint16_t SpriteRenderer::add_material(const Material &material)
+    {
+        if (!m_free_materials.empty())
+        {
+            const uint16_t id = m_free_materials.back();
+            m_free_materials.pop_back();
+            m_materials[id] = material;
+            return id;
+        }
+
+        m_materials.push_back(material);
+        return static_cast<uint16_t>(m_materials.size() - 1);
+    }
+
+    void SpriteRenderer::unregister_sheet(const util::SpriteSheet &sheet)
+    {
+        const auto it = m_sheet_materials.find(&sheet);
+        if (it == m_sheet_materials.end())
+        {
+            return;
+        }
+
+        // Array materials are shared by every sheet in the array and stay.
+        const uint16_t id = it->second;
+        m_sheet_materials.erase(it);
+        if (m_materials[id].sheet == &sheet)
+        {
+            m_materials[id] = Material{};
+            m_free_materials.push_back(id);
+        }
+    }
+
+    uint8_t SpriteRenderer::slot_for(const util::SpriteSheet &sheet) const noexcept
+    {
+        if (sheet.array())
+        {
+            return slot_for(*sheet.array());
+        }
+
+        if (m_batch_type == BatchType::Font)
+        {
+            return FontShader;
+        }
+
+        if (m_night_compositing && sheet.has_shadow() && sheet.has_mask())
+        {
+            return NightShadowMaskShader;
+        }
+        if (m_night_compositing && sheet.has_shadow())
+        {
+            return NightShadowShader;
+        }
+        if (m_night_compositing && sheet.has_mask())
+        {
+            return NightMaskShader;
+        }
+        return SpriteShader;
+    }
+
+    uint8_t SpriteRenderer::slot_for(const util::SheetArray &array) const noexcept
+    {
+        const bool overlays = m_batch_type == BatchType::Sprite && (array.has_shadow() || array.has_mask());
+        return (m_night_compositing && overlays) ? NightArrayShader : ArrayShader;
+    }
+
+    util::AlphaClass SpriteRenderer::alpha_for(const util::SpriteSheet &sheet, const SpriteInstance *instance) const noexcept
+    {
+        // Overlay passes blend onto what the base pass drew, and the array
+        // passes draw every sheet of the array in one run.
+        const bool overlays = sheet.has_shadow() || sheet.has_mask() ||
+                              (sheet.array() && (sheet.array()->has_shadow() || sheet.array()->has_mask()));
+        if (!depth_sorted() || overlays)
+        {
+            return util::AlphaClass::Translucent;
+        }
+
+        if (instance && !(instance->flags & SpriteAnimated))
+        {
+            return sheet.frame_alpha(instance->frame_index);
+        }
+        return sheet.alpha_class();
+    }
+
+    util::AlphaClass SpriteRenderer::alpha_for(const util::SheetArray &array) const noexcept
+    {
+        return depth_sorted() ? array.alpha_class() : util::AlphaClass::Translucent;
+    }
+
+    uint8_t SpriteRenderer::pass_for(util::AlphaClass alpha, uint8_t &slot) noexcept
+    {
+        if (alpha == util::AlphaClass::Translucent)
+        {
+            return sort_key::TranslucentPass;
+        }
+        if (alpha == util::AlphaClass::Cutout)
+        {
+            slot = slot == ArrayShader ? CutoutArrayShader : CutoutShader;
+        }
+        return sort_key::OpaquePass;
     }
 
     void SpriteRenderer::submit(util::SpriteSheet *sheet, const SpriteInstance &instance)
@@ -39,134 +286,585 @@ namespace renderer
             return;
         }
 
-        if (m_buckets.bucket_count() >= MaxInstances)
+        uint8_t shader = slot_for(*sheet);
+        const uint8_t pass = pass_for(alpha_for(*sheet, &instance), shader);
+
+        // Top-down y-depth: a sprite's feet (bottom edge) decide what it overlaps.
+        const float depth = instance.pos.y + instance.size.y;
+
+        const uint64_t key = sort_key::make(
+            instance.layer, pass, shader, material_for(*sheet), depth, m_layer_sort[instance.layer]);
+
+        m_queue.push(key, static_cast<uint32_t>(m_instances.size()));
+        m_instances.push_back(pack_instance(*sheet, instance));
+        ++m_sprites_submitted;
+    }
+
+    void SpriteRenderer::submit_glyphs(util::SpriteSheet *sheet, std::span<const GpuSpriteInstance> glyphs,
+                                       glm::vec2 offset, uint8_t layer)
+    {
+        if (!sheet || glyphs.empty())
         {
-            end_batch();
-            begin_batch(m_proj, m_batch_type);
+            return;
         }
 
-        m_buckets[sheet].push_back(instance);
+        // A run must fit one ring upload.
+        glyphs = glyphs.first(std::min(glyphs.size(), MaxInstances));
+
+        uint8_t shader = slot_for(*sheet);
+        const uint8_t pass = pass_for(alpha_for(*sheet, nullptr), shader);
+
+        const uint64_t key = sort_key::make(
+            layer, pass, shader, material_for(*sheet), offset.y, m_layer_sort[layer]);
+
+        m_queue.push(key, GlyphRunPayload | static_cast<uint32_t>(m_glyph_runs.size()));
+        m_glyph_runs.push_back(GlyphRun{static_cast<uint32_t>(m_instances.size()), static_cast<uint32_t>(glyphs.size())});
+
+        const std::size_t first = m_instances.size();
+        m_instances.insert(m_instances.end(), glyphs.begin(), glyphs.end());
+        for (std::size_t i = first; i < m_instances.size(); ++i)
+        {
+            m_instances[i].pos += offset;
+        }
+
+        m_sprites_submitted += glyphs.size();
+    }
+
+    void SpriteRenderer::submit_static(const StaticSpriteBatch &batch)
+    {
+        const auto &ranges = batch.ranges();
+
+        for (size_t r = 0; r < ranges.size(); ++r)
+        {
+            const auto &range = ranges[r];
+
+            uint16_t material = 0;
+            uint8_t shader = SpriteShader;
+            util::AlphaClass alpha = util::AlphaClass::Translucent;
+
+            if (range.array)
+            {
+                material = material_for(*range.array);
+                shader = slot_for(*range.array);
+                alpha = alpha_for(*range.array);
+            }
+            else if (range.sheet)
+            {
+                material = material_for(*range.sheet);
+                shader = slot_for(*range.sheet);
+                alpha = alpha_for(*range.sheet, nullptr);
+            }
+            else
+            {
+                continue;
+            }
+
+            const uint8_t pass = pass_for(alpha, shader);
+
+            // Retained ranges can't be y-sorted internally; they sort as one
+            // draw (opaque ones are resolved per pixel by the depth test).
+            // Translucent ranges of a layer tie at depth 0 and fall back to
+            // shader and material order, which is stable from run to run
+            // (materials are numbered on first use, ranges in add() order).
+            const uint64_t key = sort_key::make(
+                batch.layer(), pass, shader, material, 0.0f, m_layer_sort[batch.layer()]);
+
+            m_queue.push(key, StaticPayload | static_cast<uint32_t>(m_static_draws.size()));
+            m_static_draws.push_back(StaticDraw{&batch, r});
+            m_sprites_submitted += static_cast<std::uint64_t>(range.count);
+        }
     }
 
     void SpriteRenderer::end_batch()
     {
-        if (m_buckets.empty())
+        PROFILE_SCOPE("SpriteRenderer::end_batch");
+
+        if (m_queue.empty())
         {
             return;
         }
 
-        Shader &shader = (m_batch_type == BatchType::Font)
-                             ? m_font_shader
-                             : m_sprite_shader;
+        m_queue.sort();
 
-        shader.use();
-        shader.set_mat4("u_proj", m_proj);
+        // Code outside the renderer may have touched bindings since the last batch.
+        m_state.invalidate();
+        m_current_slot = -1;
 
-        if (m_batch_type == BatchType::Font)
+        m_state.bind_vertex_array(m_vao);
+        m_state.enable_blend(true);
+        m_state.enable_depth_test(depth_sorted());
+        if (depth_sorted())
         {
-            shader.set_vec4("u_color", {1.0f, 1.0f, 1.0f, 1.0f});
+            // Equal depth (same layer and feet row) keeps submission order.
+            m_state.depth_func(GL_LEQUAL);
         }
+        m_state.bind_texture(SequenceFramesUnit, GL_TEXTURE_BUFFER, m_sequences.frames_texture());
+        m_state.bind_texture(SequencesUnit, GL_TEXTURE_BUFFER, m_sequences.sequences_texture());
 
-        glBindVertexArray(m_vao);
-        glBindBuffer(GL_ARRAY_BUFFER, m_instance_vbo);
+        const bool indirect = m_backend == DrawBackend::MultiDrawIndirect;
+        const auto emit = [this, indirect](const InstanceRange &range)
+        {
+            indirect ? record_indirect(range) : draw_direct(range);
+        };
+
+        const auto entries = m_queue.entries();
 
-        for (auto &[sheet, instances] : m_buckets)
+        std::size_t i = 0;
+        while (i < entries.size())
         {
-            if (!sheet || instances.empty())
+            const uint64_t state = sort_key::state(entries[i].key);
+            const uint8_t slot = sort_key::shader(entries[i].key);
+            const uint16_t material = sort_key::material(entries[i].key);
+            const uint8_t pass = sort_key::pass(entries[i].key);
+            const uint8_t layer = sort_key::layer(entries[i].key);
+
+            // Retained range: already on the GPU, just draw.
+            if (entries[i].payload & StaticPayload)
             {
+                const StaticDraw &draw = m_static_draws[entries[i].payload & ~StaticPayload];
+                const auto &range = draw.batch->ranges()[draw.range];
+
+                emit(InstanceRange{slot, material, draw.batch->buffer(), range.offset, range.count, pass, layer});
+
+                ++i;
                 continue;
             }
 
-            // --------------------
-            // 1) Base sprite (always)
-            // --------------------
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-            shader.set_vec4("u_color", {1.0f, 1.0f, 1.0f, 1.0f});
-            sheet->base_sprite().texture.bind(0);
+            // Dynamic run: every following entry with the same state shares the draw.
+            std::size_t end = i + 1;
+            while (end < entries.size() &&
+                   !(entries[end].payload & StaticPayload) &&
+                   sort_key::state(entries[end].key) == state)
+            {
+                ++end;
+            }
 
-            std::size_t offset = 0;
-            while (offset < instances.size())
+            // Each chunk is uploaded once; base, shadow and mask passes all draw
+            // from the same ring range.
+            while (i < end)
             {
-                const std::size_t count =
-                    std::min<std::size_t>(MaxInstances, instances.size() - offset);
+                // Whole entries up to MaxInstances instances; glyph runs count
+                // every glyph.
+                std::size_t last = i;
+                std::size_t count = 0;
+                if (m_glyph_runs.empty())
+                {
+                    last = i + std::min<std::size_t>(MaxInstances, end - i);
+                    count = last - i;
+                }
+                else
+                {
+                    while (last < end && (count == 0 || count + instance_count(entries[last]) <= MaxInstances))
+                    {
+                        count += instance_count(entries[last]);
+                        ++last;
+                    }
+                }
 
-                glBufferSubData(
-                    GL_ARRAY_BUFFER,
-                    0,
-                    count * sizeof(SpriteInstance),
-                    instances.data() + offset);
+                // Recorded commands point into the current region; draw them
+                // before the ring moves on and may orphan or reuse memory.
+                if (indirect && count * sizeof(GpuSpriteInstance) > m_ring.available())
+                {
+                    flush_indirect();
+                }
 
-                glDrawArraysInstanced(GL_TRIANGLES, 0, 6, (GLsizei)count);
-                offset += count;
+                const std::size_t offset = upload_run(entries.subspan(i, last - i), count);
+                emit(InstanceRange{slot, material, m_ring.buffer(), offset, (GLsizei)count, pass, layer});
+
+                i = last;
             }
+        }
 
-            // --------------------
-            // 2) Shadow pass (optional)
-            // --------------------
-            if (m_batch_type == BatchType::Sprite && sheet->has_shadow())
+        if (indirect)
+        {
+            flush_indirect();
+        }
+
+        if (m_gpu_timing)
+        {
+            m_timer.end();
+        }
+
+        // Leave the default (premultiplied) blend and depth state for code
+        // drawing after us. Program and textures stay bound; the next batch
+        // invalidates anyway.
+        m_state.enable_blend(true);
+        m_state.blend_func(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        m_state.depth_mask(true);
+        m_state.depth_func(GL_LESS);
+        m_state.enable_depth_test(false);
+        m_state.bind_vertex_array(0);
+    }
+
+    void SpriteRenderer::draw_direct(const InstanceRange &range)
+    {
+        const Material &material = m_materials[range.material];
+
+        bind_shader(range.slot);
+        bind_pass(range.slot, range.pass, range.layer);
+        bind_material(material);
+        bind_instance_attributes(range.buffer, range.offset);
+
+        draw_material(material, range.slot, DrawRange{.material = range.material, .instances = range.count});
+    }
+
+    void SpriteRenderer::record_indirect(const InstanceRange &range)
+    {
+        // Attributes stay at offset 0 of the buffer; baseInstance selects the range.
+        const IndirectCommand command{
+            .count = 6,
+            .instance_count = static_cast<GLuint>(range.count),
+            .first = 0,
+            .base_instance = static_cast<GLuint>(range.offset / sizeof(GpuSpriteInstance)),
+        };
+
+        if (!m_groups.empty())
+        {
+            IndirectGroup &group = m_groups.back();
+            if (group.slot == range.slot && group.material == range.material && group.buffer == range.buffer &&
+                group.pass == range.pass && group.layer == range.layer)
             {
-                glEnable(GL_BLEND);
-                glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+                ++group.commands;
+                group.instances += range.count;
+                m_commands.push_back(command);
+                return;
+            }
+        }
 
-                shader.set_vec4("u_color", {0.0f, 0.0f, 0.0f, 0.6f});
-                sheet->shadow_sprite().texture.bind(0);
+        m_groups.push_back(IndirectGroup{range.slot, range.material, range.buffer, m_commands.size(), 1, range.count,
+                                         range.pass, range.layer});
+        m_commands.push_back(command);
+    }
 
-                std::size_t offset = 0;
-                while (offset < instances.size())
-                {
-                    const std::size_t count =
-                        std::min<std::size_t>(MaxInstances, instances.size() - offset);
+    void SpriteRenderer::flush_indirect()
+    {
+        if (m_commands.empty())
+        {
+            return;
+        }
 
-                    glBufferSubData(
-                        GL_ARRAY_BUFFER,
-                        0,
-                        count * sizeof(SpriteInstance),
-                        instances.data() + offset);
+        // Orphan and refill: the driver hands out fresh storage if the previous
+        // commands are still in flight.
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirect_buffer);
+        m_indirect_capacity = std::max(m_indirect_capacity, m_commands.size());
+        glBufferData(GL_DRAW_INDIRECT_BUFFER,
+                     static_cast<GLsizeiptr>(m_indirect_capacity * sizeof(IndirectCommand)),
+                     nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0,
+                        static_cast<GLsizeiptr>(m_commands.size() * sizeof(IndirectCommand)),
+                        m_commands.data());
+        m_frame_stats.bytes_uploaded += m_commands.size() * sizeof(IndirectCommand);
+
+        for (const IndirectGroup &group : m_groups)
+        {
+            const Material &material = m_materials[group.material];
 
-                    glDrawArraysInstanced(GL_TRIANGLES, 0, 6, (GLsizei)count);
-                    offset += count;
-                }
+            bind_shader(group.slot);
+            bind_pass(group.slot, group.pass, group.layer);
+            bind_material(material);
+            bind_instance_attributes(group.buffer, 0);
+
+            draw_material(material, group.slot,
+                          DrawRange{.material = group.material, .instances = group.instances,
+                                    .first_command = group.first_command, .commands = group.commands});
+        }
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+        m_commands.clear();
+        m_groups.clear();
+    }
+
+    void SpriteRenderer::bind_shader(uint8_t slot)
+    {
+        if (slot != m_current_slot)
+        {
+            bind_frame_uniforms(slot);
+            m_current_slot = slot;
+        }
+    }
+
+    void SpriteRenderer::bind_pass(uint8_t slot, uint8_t pass, uint8_t layer)
+    {
+        // Opaque and cutout fragments overwrite; translucent ones blend over
+        // them and must not hide what is drawn behind them later.
+        const bool opaque = pass == sort_key::OpaquePass;
+        m_state.enable_blend(!opaque);
+        m_state.depth_mask(opaque);
+
+        // Layers map to disjoint depth bands (see sprite.vert).
+        set_uniform(shader_for(slot), m_uniforms[slot].layer, static_cast<float>(layer));
+    }
+
+    void SpriteRenderer::set_gpu_timing(bool enabled)
+    {
+        m_gpu_timing = enabled;
+    }
+
+    void SpriteRenderer::end_frame()
+    {
+        m_ring.end_frame();
+
+        const GlState::Stats &state = m_state.stats();
+        m_frame_stats.draw_calls = state.draws;
+        m_frame_stats.texture_binds = state.texture_binds;
+        m_frame_stats.blend_changes = state.blend_changes;
+        m_frame_stats.state = state;
+
+        // Filled in the snapshot, so gpu_buckets keeps its capacity.
+        m_last_frame_stats = m_frame_stats;
+        if (m_gpu_timing)
+        {
+            read_gpu_times(m_last_frame_stats);
+        }
+
+        m_frame_stats = {};
+        m_state.reset_stats();
+    }
+
+    void SpriteRenderer::read_gpu_times(FrameStats &stats)
+    {
+        // One section per material, batch type and pass; freed material IDs
+        // are reused, and a resize just zeroes the times read below.
+        const std::size_t sections = m_materials.size() * BatchTypeCount * PassCount;
+        if (m_timer.section_ms().size() != sections)
+        {
+            m_timer.set_section_count(sections);
+        }
+
+        m_timer.end_frame();
+        stats.gpu_stale = m_timer.stale();
+
+        const auto ms = m_timer.section_ms();
+        for (std::size_t section = 0; section < ms.size(); ++section)
+        {
+            const double t = ms[section];
+            if (t <= 0.0)
+            {
+                continue;
             }
-            
-            // --------------------
-            // 3) Mask pass (optional, multiply)
-            // --------------------
-            if (m_batch_type == BatchType::Sprite && sheet->has_mask())
+
+            const auto pass = static_cast<RenderPass>(section % PassCount);
+            const auto batch = static_cast<BatchType>(section / PassCount % BatchTypeCount);
+            const auto material = static_cast<uint16_t>(section / (PassCount * BatchTypeCount));
+
+            stats.gpu_buckets.push_back(GpuBucketTime{material, batch, pass, t});
+            stats.gpu_ms[static_cast<std::size_t>(batch)][pass] += t;
+            stats.gpu_total_ms += t;
+        }
+    }
+
+    void SpriteRenderer::bind_frame_uniforms(uint8_t slot)
+    {
+        Shader &shader = shader_for(slot);
+        const ShaderUniforms &u = m_uniforms[slot];
+
+        // Uniform values persist in the program; unchanged ones are skipped.
+        m_state.use_program(shader.id());
+        set_uniform(shader, u.proj, m_proj);
+        set_uniform(shader, u.time, static_cast<float>(std::fmod(m_time, m_sequences.period())));
+        set_uniform(shader, u.color, glm::vec4{1.0f, 1.0f, 1.0f, 1.0f});
+    }
+
+    std::size_t SpriteRenderer::upload_run(std::span<const RenderQueue::Entry> run, std::size_t instances)
+    {
+        const std::size_t bytes = instances * sizeof(GpuSpriteInstance);
+        m_frame_stats.bytes_uploaded += bytes;
+
+        // Non-persistent modes bind the ring to GL_ARRAY_BUFFER behind the tracker.
+        m_state.forget_array_buffer();
+
+        // Gather in sorted order straight into ring memory; no staging copy
+        // inside the driver.
+        std::size_t offset = 0;
+        auto *dst = static_cast<GpuSpriteInstance *>(m_ring.map(bytes, offset));
+
+        for (const auto &entry : run)
+        {
+            if (entry.payload & GlyphRunPayload)
             {
-                glEnable(GL_BLEND);
-                glBlendFunc(GL_DST_COLOR, GL_ZERO); // multiply
+                const GlyphRun &glyphs = m_glyph_runs[entry.payload & ~GlyphRunPayload];
+                dst = std::copy_n(m_instances.begin() + glyphs.first, glyphs.count, dst);
+                continue;
+            }
+            *dst++ = m_instances[entry.payload];
+        }
 
-                shader.set_vec4("u_color", {1.0f, 1.0f, 1.0f, 1.0f});
-                sheet->mask_sprite().texture.bind(0);
+        m_ring.commit();
+        return offset;
+    }
 
-                offset = 0;
-                while (offset < instances.size())
-                {
-                    const std::size_t count =
-                        std::min<std::size_t>(MaxInstances, instances.size() - offset);
+    void SpriteRenderer::bind_material(const Material &material)
+    {
+        if (material.array)
+        {
+            m_state.bind_texture(TextureUnit, GL_TEXTURE_2D_ARRAY, material.array->texture().id());
+            m_state.bind_texture(FrameTableUnit, GL_TEXTURE_BUFFER, material.array->layer_table().id());
+            m_state.bind_texture(TrimTableUnit, GL_TEXTURE_BUFFER, material.array->trim_table().id());
+        }
+        else
+        {
+            // Frame IDs resolve to UVs in the vertex shader via the sheet's table.
+            m_state.bind_texture(FrameTableUnit, GL_TEXTURE_BUFFER, material.sheet->uv_table().id());
+            m_state.bind_texture(TrimTableUnit, GL_TEXTURE_BUFFER, material.sheet->trim_table().id());
+        }
+    }
 
-                    glBufferSubData(
-                        GL_ARRAY_BUFFER,
-                        0,
-                        count * sizeof(SpriteInstance),
-                        instances.data() + offset);
+    void SpriteRenderer::draw_material(const Material &material, uint8_t slot, const DrawRange &range)
+    {
+        if (is_night_slot(slot))
+        {
+            draw_night_composite(material, range);
+        }
+        else if (material.array)
+        {
+            draw_array_passes(*material.array, slot, range);
+        }
+        else
+        {
+            draw_passes(*material.sheet, slot, range);
+        }
+    }
 
-                    glDrawArraysInstanced(GL_TRIANGLES, 0, 6, (GLsizei)count);
-                    offset += count;
-                }
+    void SpriteRenderer::issue(const DrawRange &range, RenderPass pass)
+    {
+        if (m_gpu_timing)
+        {
+            m_timer.begin(gpu_section(range.material, m_batch_type, pass));
+        }
+
+        if (range.commands > 0)
+        {
+            const auto offset = static_cast<std::uintptr_t>(range.first_command * sizeof(IndirectCommand));
+            gl_extensions().MultiDrawArraysIndirect(GL_TRIANGLES, reinterpret_cast<const void *>(offset), range.commands, 0);
+        }
+        else
+        {
+            glDrawArraysInstanced(GL_TRIANGLES, 0, 6, range.instances);
+        }
+        m_state.count_draw();
+        m_frame_stats.instances += static_cast<std::uint64_t>(range.instances);
+    }
+
+    void SpriteRenderer::draw_passes(util::SpriteSheet &sheet, uint8_t slot, const DrawRange &range)
+    {
+        Shader &shader = shader_for(slot);
+        const ShaderUniforms &u = m_uniforms[slot];
+
+        // --------------------
+        // 1) Base sprite (always)
+        // --------------------
+        m_state.blend_func(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+        set_uniform(shader, u.color, glm::vec4{1.0f, 1.0f, 1.0f, 1.0f});
+        m_state.bind_texture(TextureUnit, GL_TEXTURE_2D, sheet.base_sprite().texture.id());
+
+        issue(range, BasePass);
+
+        // --------------------
+        // 2) Shadow pass (optional)
+        // --------------------
+        if (m_batch_type == BatchType::Sprite && sheet.has_shadow())
+        {
+            m_state.blend_func(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+            set_uniform(shader, u.color, glm::vec4{0.0f, 0.0f, 0.0f, 0.6f});
+            m_state.bind_texture(TextureUnit, GL_TEXTURE_2D, sheet.shadow_sprite().texture.id());
+
+            issue(range, ShadowPass);
+        }
+
+        // --------------------
+        // 3) Mask pass (optional, multiply)
+        // --------------------
+        if (m_batch_type == BatchType::Sprite && sheet.has_mask())
+        {
+            m_state.blend_func(GL_DST_COLOR, GL_ZERO); // multiply
+
+            set_uniform(shader, u.color, glm::vec4{1.0f, 1.0f, 1.0f, 1.0f});
+            m_state.bind_texture(TextureUnit, GL_TEXTURE_2D, sheet.mask_sprite().texture.id());
+
+            issue(range, MaskPass);
+        }
 
-                // Restore default blend
-                glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        // The default blend is restored lazily by the next base pass.
+    }
+
+    void SpriteRenderer::draw_array_passes(const util::SheetArray &array, uint8_t slot, const DrawRange &range)
+    {
+        const ShaderUniforms &u = m_uniforms[slot];
+
+        // Base: one draw for every sheet in the array.
+        m_state.blend_func(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        Shader &shader = shader_for(slot);
+        set_uniform(shader, u.pass, 0);
+        issue(range, BasePass);
+
+        // Overlay passes look up the overlay layer per instance; instances whose
+        // sheet has no overlay collapse to a clipped quad in the vertex shader.
+        if (array.has_shadow())
+        {
+            set_uniform(shader, u.pass, 1);
+            issue(range, ShadowPass);
+        }
+
+        if (array.has_mask())
+        {
+            m_state.blend_func(GL_DST_COLOR, GL_ZERO); // multiply
+            set_uniform(shader, u.pass, 2);
+            issue(range, MaskPass);
+        }
+    }
+
+    void SpriteRenderer::draw_night_composite(const Material &material, const DrawRange &range)
+    {
+        // Array overlays live in the same texture array, bound by bind_material().
+        if (material.sheet)
+        {
+            util::SpriteSheet &sheet = *material.sheet;
+
+            m_state.bind_texture(TextureUnit, GL_TEXTURE_2D, sheet.base_sprite().texture.id());
+            if (sheet.has_shadow())
+            {
+                m_state.bind_texture(ShadowUnit, GL_TEXTURE_2D, sheet.shadow_sprite().texture.id());
+            }
+            if (sheet.has_mask())
+            {
+                m_state.bind_texture(MaskUnit, GL_TEXTURE_2D, sheet.mask_sprite().texture.id());
             }
         }
 
-        glBindVertexArray(0);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glUseProgram(0);
+        // out = src0 + dst * src1 (see sprite.frag)
+        m_state.blend_func(GL_ONE, GL_SRC1_COLOR);
+        issue(range, CompositePass);
+    }
+
+    void SpriteRenderer::bind_instance_attributes(GLuint buffer, std::size_t offset)
+    {
+        if (buffer == m_attrib_buffer && offset == m_attrib_offset)
+        {
+            return;
+        }
+        m_attrib_buffer = buffer;
+        m_attrib_offset = offset;
+
+        const auto base = static_cast<std::uintptr_t>(offset);
+        const auto at = [base](std::size_t member)
+        { return reinterpret_cast<void *>(base + member); };
+
+        m_state.bind_array_buffer(buffer);
+
+        // layout(location=1) vec2 i_pos
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(GpuSpriteInstance), at(offsetof(GpuSpriteInstance, pos)));
+
+        // layout(location=2) vec2 i_size (12.4 fixed point, scaled in the shader)
+        glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_FALSE, sizeof(GpuSpriteInstance), at(offsetof(GpuSpriteInstance, size)));
+
+        // layout(location=3) uvec2 i_frame (frame, flags)
+        glVertexAttribIPointer(3, 2, GL_UNSIGNED_SHORT, sizeof(GpuSpriteInstance), at(offsetof(GpuSpriteInstance, frame)));
     }
 
-    void SpriteRenderer::create_buffers()
+    void SpriteRenderer::create_buffers(InstanceRing::Mode stream_mode)
     {
         // Unit quad (two triangles) in local space: [0..1] x [0..1]
         const float quad[] = {
@@ -190,25 +888,17 @@ namespace renderer
         glEnableVertexAttribArray(0);
         glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void *)0);
 
-        // Instance buffer (dynamic)
-        glGenBuffers(1, &m_instance_vbo);
-        glBindBuffer(GL_ARRAY_BUFFER, m_instance_vbo);
-        glBufferData(GL_ARRAY_BUFFER, MaxInstances * sizeof(SpriteInstance), nullptr, GL_STREAM_DRAW);
+        // Instance data streams through a ring; pointers are re-based per draw
+        // in bind_instance_attributes().
+        m_ring.create(MaxInstances * sizeof(GpuSpriteInstance), stream_mode);
 
-        // layout(location=1) vec2 i_pos
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void *)offsetof(SpriteInstance, pos));
-        glVertexAttribDivisor(1, 1);
-
-        // layout(location=2) vec2 i_size
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void *)offsetof(SpriteInstance, size));
-        glVertexAttribDivisor(2, 1);
+        for (GLuint loc = 1; loc <= 3; ++loc)
+        {
+            glEnableVertexAttribArray(loc);
+            glVertexAttribDivisor(loc, 1);
+        }
 
-        // layout(location=3) vec4 i_uv
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void *)offsetof(SpriteInstance, uv));
-        glVertexAttribDivisor(3, 1);
+        bind_instance_attributes(m_ring.buffer(), 0);
 
         glBindBuffer(GL_ARRAY_BUFFER, 0);
         glBindVertexArray(0);
@@ -216,10 +906,11 @@ namespace renderer
 
     void SpriteRenderer::destroy_buffers()
     {
-        if (m_instance_vbo)
+        m_ring.release();
+        if (m_indirect_buffer)
         {
-            glDeleteBuffers(1, &m_instance_vbo);
-            m_instance_vbo = 0;
+            glDeleteBuffers(1, &m_indirect_buffer);
+            m_indirect_buffer = 0;
         }
         if (m_quad_vbo)
         {
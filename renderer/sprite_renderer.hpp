@@ -1,33 +1,96 @@
 #pragma once
 
-#include <unordered_map>
+#include <array>
+#include <cstdint>
 #include <vector>
 #include <span>
+#include <unordered_map>
 
 #include <glad/gl.h>
 #include <glm/mat4x4.hpp>
 #include <glm/vec2.hpp>
 #include <glm/vec4.hpp>
 
+#include "gl_state.hpp"
+#include "gpu_timer.hpp"
+#include "instance_ring.hpp"
+#include "render_queue.hpp"
+#include "sequence_table.hpp"
 #include "shader.hpp"
+#include "util/alpha_class.hpp"
+#include "util/sheet_array.hpp"
 #include "util/sprite_sheet.hpp"
 
 namespace renderer
 {
+    class StaticSpriteBatch;
+
+    enum SpriteFlags : uint16_t
+    {
+        SpriteFlipX = 1u << 0,
+        SpriteFlipY = 1u << 1,
+
+        // frame_index is a SequenceTable ID; the vertex shader picks the frame
+        // from u_time and the instance phase.
+        SpriteAnimated = 1u << 2,
+    };
+
+    // Low flag bits; the upper 12 bits of GpuSpriteInstance::flags carry the
+    // start phase of animated instances.
+    constexpr uint16_t SpriteFlagBits = 0x000F;
+    constexpr int SpritePhaseShift = 4;
+
+    // CPU-side sprite description passed to SpriteRenderer::submit.
+    // Only pos, size, frame_index, flags and phase reach the GPU.
     struct SpriteInstance
     {
         glm::vec2 pos;
         glm::vec2 size;
-        glm::vec4 uv;
         unsigned int frame_index;
-        std::span<const unsigned int> frame_sequence;
-        double seconds_per_frame;
+        uint16_t flags = 0;
+
+        // SpriteAnimated only: start offset as a fraction of one loop [0, 1).
+        // Instances left at 0 share the sequence's global clock (e.g. belts).
+        float phase = 0.0f;
+
+        // Draw order: lower layers first. Within a layer see LayerSort.
+        uint8_t layer = 0;
+    };
+
+    // Packed per-instance record uploaded to the GPU (16 bytes).
+    // - pos stays 32-bit float: the world is already wider than 16-bit fixed point covers
+    // - size is 12.4 fixed point pixels
+    // - frame indexes the sheet's UV table (see util::SpriteSheet::uv_table),
+    //   the array layer for packed sheets, or a SequenceTable ID when animated
+    struct GpuSpriteInstance
+    {
+        glm::vec2 pos;
+        uint16_t size[2];
+        uint16_t frame;
+        uint16_t flags;
+    };
+
+    static_assert(sizeof(GpuSpriteInstance) == 16, "GpuSpriteInstance must stay tightly packed");
+
+    // Resolves the frame for sheets packed into texture arrays.
+    GpuSpriteInstance pack_instance(const util::SpriteSheet &sheet, const SpriteInstance &instance) noexcept;
+
+    // How end_batch() submits draws.
+    // - Direct:            one glDrawArraysInstanced per run, chunk and pass
+    // - MultiDrawIndirect: consecutive runs sharing shader, material and buffer
+    //                      become one glMultiDrawArraysIndirect per pass (GL 4.3)
+    enum class DrawBackend
+    {
+        Direct,
+        MultiDrawIndirect
     };
 
     class SpriteRenderer
     {
     public:
-        SpriteRenderer();
+        // Falls back to DrawBackend::Direct when the context lacks multi-draw indirect.
+        explicit SpriteRenderer(InstanceRing::Mode stream_mode = InstanceRing::Mode::Persistent,
+                                DrawBackend backend = DrawBackend::MultiDrawIndirect);
         ~SpriteRenderer();
 
         enum class BatchType
@@ -35,6 +98,48 @@ namespace renderer
             Sprite,
             Font
         };
+        static constexpr std::size_t BatchTypeCount = 2;
+
+        // Draw passes a batch can issue; see draw_passes() / draw_night_composite().
+        enum RenderPass : uint8_t
+        {
+            BasePass,
+            ShadowPass,
+            MaskPass,
+            CompositePass,
+            PassCount
+        };
+
+        // GPU time of one bucket: a material's draws in one pass of one batch type.
+        struct GpuBucketTime
+        {
+            uint16_t material = 0;
+            BatchType batch = BatchType::Sprite;
+            RenderPass pass = BasePass;
+            double ms = 0.0;
+        };
+
+        // Per-frame statistics, snapshotted by end_frame().
+        struct FrameStats
+        {
+            // GPU time per batch type and pass (set_gpu_timing), summed over
+            // gpu_buckets. Lags the counters below by
+            // GpuTimer::FrameLatency - 1 frames.
+            std::array<std::array<double, PassCount>, BatchTypeCount> gpu_ms{};
+            double gpu_total_ms = 0.0;
+            bool gpu_stale = false; // results not ready in time: times are zero
+
+            // Buckets that took any time, by material then batch type and pass.
+            std::vector<GpuBucketTime> gpu_buckets;
+
+            std::uint32_t batches = 0;
+            std::uint32_t draw_calls = 0;
+            std::uint64_t instances = 0;      // summed over every pass
+            std::uint64_t bytes_uploaded = 0; // streamed instances + indirect commands
+            std::uint32_t texture_binds = 0;
+            std::uint32_t blend_changes = 0;
+            GlState::Stats state;
+        };
 
         SpriteRenderer(const SpriteRenderer &) = delete;
         SpriteRenderer &operator=(const SpriteRenderer &) = delete;
@@ -42,31 +147,311 @@ namespace renderer
         void begin_batch(const glm::mat4 &proj, BatchType type = BatchType::Sprite);
 
         void submit(util::SpriteSheet *sheet, const SpriteInstance &instance);
+
+        // Draws a retained batch in this batch; nothing is uploaded.
+        // The batch must outlive end_batch().
+        void submit_static(const StaticSpriteBatch &batch);
+
+        // Queues pre-packed instances (pack_instance for `sheet`, e.g. a cached
+        // text run) translated by `offset`, as one entry: the run sorts as a
+        // unit at depth offset.y and is copied in bulk, with no per-instance key.
+        void submit_glyphs(util::SpriteSheet *sheet, std::span<const GpuSpriteInstance> glyphs,
+                           glm::vec2 offset, uint8_t layer = 0);
+
         void end_batch();
 
+        // Ordering of opaque sprites within `layer` (default LayerSort::Batched);
+        // translucent ones are always y-sorted (see sort_key).
+        void set_layer_sort(uint8_t layer, LayerSort sort) noexcept { m_layer_sort[layer] = sort; }
+
+        // Draw sheets with night overlays in one pass (dual-source blending) instead
+        // of separate base, shadow and mask draws. Applies to later submits.
+        void set_night_compositing(bool enabled) noexcept { m_night_compositing = enabled; }
+
+        // Sprite batches draw opaque and cutout frames first, front to back with
+        // depth writes and no blending, then translucent ones back to front
+        // against that depth. Needs a depth buffer on the target, cleared every
+        // frame. Applies to later submits.
+        void set_depth_sorting(bool enabled) noexcept { m_depth_sorting = enabled; }
+
+        // Clock for SpriteAnimated instances, in seconds. Wrapped to
+        // SequenceTable::period() before it is narrowed to the float uniform.
+        void set_time(double seconds) noexcept { m_time = seconds; }
+
+        // Forgets `sheet` (no-op if never drawn); its material ID is reused.
+        // Owners call this before destroying a sheet this renderer has drawn,
+        // outside begin_batch()/end_batch().
+        void unregister_sheet(const util::SpriteSheet &sheet);
+
+        // Register FrameSequences here and upload() before drawing animated instances.
+        SequenceTable &sequences() noexcept { return m_sequences; }
+
+        // Call once per frame after the last end_batch; fences this frame's
+        // instance memory so the ring can reuse it safely.
+        void end_frame();
+
+        InstanceRing::Mode stream_mode() const noexcept { return m_ring.mode(); }
+        DrawBackend draw_backend() const noexcept { return m_backend; }
+
+        // Times the CPU blocked waiting for the GPU to release ring memory.
+        std::uint64_t fence_waits() const noexcept { return m_ring.fence_waits(); }
+
+        // Sprites submitted since construction, retained ranges included.
+        std::uint64_t sprites_submitted() const noexcept { return m_sprites_submitted; }
+
+        // State changes issued vs. elided, and draw calls, during the last completed frame.
+        const GlState::Stats &state_stats() const noexcept { return m_last_frame_stats.state; }
+
+        // Counters and (if enabled) GPU pass timings of the last completed frame.
+        const FrameStats &frame_stats() const noexcept { return m_last_frame_stats; }
+
+        // Wraps every pass of every material in GL_TIME_ELAPSED queries. Off
+        // by default: each pass or material change costs a query.
+        void set_gpu_timing(bool enabled);
+        bool gpu_timing() const noexcept { return m_gpu_timing; }
+
         void release() {
             destroy_buffers();
-            m_sprite_shader.release();
-            m_font_shader.release();
+            m_timer.release();
+            m_sequences.release();
+            for (auto &shader : m_shaders)
+            {
+                shader.release();
+            }
         }
 
     private:
-        void create_buffers();
+        // Shader selector stored in the sort key.
+        enum ShaderSlot : uint8_t
+        {
+            SpriteShader = 0,
+            ArrayShader = 1,
+            FontShader = 2,
+
+            // Single-pass night compositing (sprite.frag NIGHT_COMPOSITE).
+            NightShadowShader = 3,
+            NightMaskShader = 4,
+            NightShadowMaskShader = 5,
+            NightArrayShader = 6,
+
+            // Depth-sorted cutout frames (sprite.frag ALPHA_TEST).
+            CutoutShader = 7,
+            CutoutArrayShader = 8,
+
+            ShaderCount
+        };
+
+        // What a sort key's material ID refers to: a sheet with its own
+        // texture, or a texture array shared by many sheets.
+        struct Material
+        {
+            util::SpriteSheet *sheet = nullptr;
+            const util::SheetArray *array = nullptr;
+        };
+
+        // Uniforms set per batch/pass, resolved once per shader.
+        struct ShaderUniforms
+        {
+            Uniform<glm::mat4> proj;
+            Uniform<float> time;
+            Uniform<glm::vec4> color;
+            Uniform<int> pass;
+            Uniform<float> layer;
+        };
+
+        // Queue payloads with this bit set index m_static_draws instead of m_instances.
+        static constexpr uint32_t StaticPayload = 0x80000000u;
+
+        // ... and with this bit, m_glyph_runs (submit_glyphs).
+        static constexpr uint32_t GlyphRunPayload = 0x40000000u;
+
+        // Consecutive instances in m_instances queued as one entry.
+        struct GlyphRun
+        {
+            uint32_t first = 0;
+            uint32_t count = 0;
+        };
+
+        struct StaticDraw
+        {
+            const StaticSpriteBatch *batch = nullptr;
+            std::size_t range = 0;
+        };
+
+        // Instances already on the GPU, ready to draw with one material.
+        struct InstanceRange
+        {
+            uint8_t slot = SpriteShader;
+            uint16_t material = 0;
+            GLuint buffer = 0;
+            std::size_t offset = 0; // bytes into buffer
+            GLsizei count = 0;
+            uint8_t pass = sort_key::TranslucentPass;
+            uint8_t layer = 0;
+        };
+
+        // What each pass draws: `instances` directly, or `commands` indirect
+        // commands starting at `first_command` in m_indirect_buffer (which then
+        // still carry their instance total in `instances`, for stats).
+        struct DrawRange
+        {
+            uint16_t material = 0; // the GPU timing bucket
+            GLsizei instances = 0;
+            std::size_t first_command = 0;
+            GLsizei commands = 0;
+        };
+
+        // Layout fixed by GL (DrawArraysIndirectCommand).
+        struct IndirectCommand
+        {
+            GLuint count;
+            GLuint instance_count;
+            GLuint first;
+            GLuint base_instance;
+        };
+
+        // Consecutive commands drawn with the same state.
+        struct IndirectGroup
+        {
+            uint8_t slot = SpriteShader;
+            uint16_t material = 0;
+            GLuint buffer = 0;
+            std::size_t first_command = 0;
+            GLsizei commands = 0;
+            GLsizei instances = 0; // over all commands, for stats
+            uint8_t pass = sort_key::TranslucentPass;
+            uint8_t layer = 0;
+        };
+
+        SpriteRenderer(InstanceRing::Mode stream_mode, DrawBackend backend, std::vector<Shader> shaders);
+
+        // All permutations in one ShaderCache::build, indexed by ShaderSlot.
+        static std::vector<Shader> build_shaders();
+
+        void create_buffers(InstanceRing::Mode stream_mode);
         void destroy_buffers();
 
+        uint16_t material_for(util::SpriteSheet &sheet);
+        uint16_t material_for(const util::SheetArray &array);
+        uint16_t add_material(const Material &material);
+        Shader &shader_for(uint8_t slot) noexcept { return m_shaders[slot]; }
+        uint8_t slot_for(const util::SpriteSheet &sheet) const noexcept;
+        uint8_t slot_for(const util::SheetArray &array) const noexcept;
+        static bool is_night_slot(uint8_t slot) noexcept { return slot >= NightShadowShader && slot <= NightArrayShader; }
+
+        // Coverage class a draw of `sheet` is sorted by; Translucent unless
+        // depth sorting applies to this batch.
+        util::AlphaClass alpha_for(const util::SpriteSheet &sheet, const SpriteInstance *instance) const noexcept;
+        util::AlphaClass alpha_for(const util::SheetArray &array) const noexcept;
+        bool depth_sorted() const noexcept { return m_depth_sorting && m_batch_type == BatchType::Sprite; }
+
+        // Sort key pass for `alpha`; Cutout also swaps `slot` for its ALPHA_TEST permutation.
+        static uint8_t pass_for(util::AlphaClass alpha, uint8_t &slot) noexcept;
+
+        // Instances behind one queue entry.
+        std::size_t instance_count(const RenderQueue::Entry &entry) const noexcept
+        {
+            return (entry.payload & GlyphRunPayload) ? m_glyph_runs[entry.payload & ~GlyphRunPayload].count : 1;
+        }
+
+        // Copies the run's `instances` instances into the ring (in sorted
+        // order) and returns their byte offset.
+        std::size_t upload_run(std::span<const RenderQueue::Entry> run, std::size_t instances);
+
+        // Direct backend: binds state for `range` and draws it right away.
+        void draw_direct(const InstanceRange &range);
+
+        // Indirect backend: queues `range` as a command; flush_indirect() uploads
+        // the commands and draws every group.
+        void record_indirect(const InstanceRange &range);
+        void flush_indirect();
+
+        void bind_shader(uint8_t slot);
+
+        // Blend and depth writes for a sort key pass, and the layer's depth band.
+        void bind_pass(uint8_t slot, uint8_t pass, uint8_t layer);
+        void bind_material(const Material &material);
+        void draw_material(const Material &material, uint8_t slot, const DrawRange &range);
+
+        // Base, shadow and mask passes over the currently bound instance range.
+        void draw_passes(util::SpriteSheet &sheet, uint8_t slot, const DrawRange &range);
+        void draw_array_passes(const util::SheetArray &array, uint8_t slot, const DrawRange &range);
+
+        // One pass: overlays are sampled in the fragment shader and folded
+        // into a dual-source blend.
+        void draw_night_composite(const Material &material, const DrawRange &range);
+        void issue(const DrawRange &range, RenderPass pass);
+
+        // GpuTimer section of a material's draws in `pass` of `batch`.
+        static std::size_t gpu_section(uint16_t material, BatchType batch, RenderPass pass) noexcept
+        {
+            return (static_cast<std::size_t>(material) * BatchTypeCount + static_cast<std::size_t>(batch)) * PassCount + pass;
+        }
+        void read_gpu_times(FrameStats &stats);
+
+        void bind_frame_uniforms(uint8_t slot);
+
+        template <typename T>
+        void set_uniform(Shader &shader, Uniform<T> uniform, const T &value)
+        {
+            if (uniform.valid())
+            {
+                m_state.count_uniform(shader.set(uniform, value));
+            }
+        }
+        void bind_instance_attributes(GLuint buffer, std::size_t offset);
+
     private:
-        Shader m_sprite_shader;
-        Shader m_font_shader;
+        std::vector<Shader> m_shaders; // indexed by ShaderSlot
+        std::array<ShaderUniforms, ShaderCount> m_uniforms{};
         BatchType m_batch_type = BatchType::Sprite;
+        bool m_night_compositing = true;
+        bool m_depth_sorting = false;
+
+        GlState m_state;
+        FrameStats m_frame_stats;
+        FrameStats m_last_frame_stats;
+
+        GpuTimer m_timer;
+        bool m_gpu_timing = false;
+        std::uint64_t m_sprites_submitted = 0;
+
+        DrawBackend m_backend = DrawBackend::Direct;
 
         GLuint m_vao{};
         GLuint m_quad_vbo{};
-        GLuint m_instance_vbo{};
+        InstanceRing m_ring;
+
+        // Instance attribute source currently set on m_vao.
+        GLuint m_attrib_buffer{};
+        std::size_t m_attrib_offset{};
+        int m_current_slot = -1;
+
+        GLuint m_indirect_buffer{};
+        std::size_t m_indirect_capacity{}; // commands
+        std::vector<IndirectCommand> m_commands;
+        std::vector<IndirectGroup> m_groups;
 
         glm::mat4 m_proj{1.0f};
+        double m_time = 0.0;
+
+        SequenceTable m_sequences;
 
+        // Largest run uploaded per draw (one ring region).
         static constexpr size_t MaxInstances = 200000;
 
-        std::unordered_map<util::SpriteSheet *, std::vector<SpriteInstance>> m_buckets;
+        // Flat render queue: submit() packs the instance and pushes one sort key.
+        // All vectors keep their capacity across batches.
+        RenderQueue m_queue;
+        std::vector<GpuSpriteInstance> m_instances;
+        std::vector<StaticDraw> m_static_draws;
+        std::vector<GlyphRun> m_glyph_runs;
+
+        // Material IDs: freed slots are reused, so the list (and the GPU
+        // timer sections sized from it) stays at the high-water mark.
+        std::vector<Material> m_materials;
+        std::vector<uint16_t> m_free_materials;
+        std::unordered_map<const util::SpriteSheet *, uint16_t> m_sheet_materials;
+        std::array<LayerSort, 256> m_layer_sort{};
     };
 }
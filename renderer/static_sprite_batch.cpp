@@ -0,0 +1,78 @@
+#include "static_sprite_batch.hpp"
+
+namespace renderer
+{
+    StaticSpriteBatch::~StaticSpriteBatch()
+    {
+        release();
+    }
+
+    void StaticSpriteBatch::add(util::SpriteSheet *sheet, const SpriteInstance &instance)
+    {
+        if (!sheet)
+        {
+            return;
+        }
+
+        const util::SheetArray *array = sheet->array();
+        const void *key = array ? static_cast<const void *>(array) : sheet;
+
+        const auto [it, inserted] = m_staging_index.try_emplace(key, m_staging.size());
+        if (inserted)
+        {
+            m_staging.push_back(Staging{array ? nullptr : sheet, array, {}});
+        }
+        m_staging[it->second].instances.push_back(pack_instance(*sheet, instance));
+    }
+
+    void StaticSpriteBatch::upload()
+    {
+        std::vector<GpuSpriteInstance> all;
+        m_ranges.clear();
+
+        const auto append = [&](util::SpriteSheet *sheet, const util::SheetArray *array, const std::vector<GpuSpriteInstance> &instances)
+        {
+            if (instances.empty())
+            {
+                return;
+            }
+
+            m_ranges.push_back(Range{
+                .sheet = sheet,
+                .array = array,
+                .offset = all.size() * sizeof(GpuSpriteInstance),
+                .count = static_cast<GLsizei>(instances.size()),
+            });
+            all.insert(all.end(), instances.begin(), instances.end());
+        };
+
+        for (const Staging &staging : m_staging)
+        {
+            append(staging.sheet, staging.array, staging.instances);
+        }
+
+        m_staging.clear();
+        m_staging_index.clear();
+
+        if (m_buffer == 0)
+        {
+            glGenBuffers(1, &m_buffer);
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(all.size() * sizeof(GpuSpriteInstance)), all.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void StaticSpriteBatch::release()
+    {
+        if (m_buffer)
+        {
+            glDeleteBuffers(1, &m_buffer);
+            m_buffer = 0;
+        }
+        m_ranges.clear();
+        m_staging.clear();
+        m_staging_index.clear();
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <glad/gl.h>
+
+#include "sprite_renderer.hpp"
+
+namespace renderer
+{
+    // Retained instance buffer for sprites that don't move.
+    //
+    // Instances are packed and uploaded once; drawing the batch costs no CPU
+    // per sprite. Combined with SpriteAnimated instances (frame resolved in the
+    // vertex shader from SequenceTable + time) animated scenery stays on the GPU.
+    class StaticSpriteBatch
+    {
+    public:
+        struct Range
+        {
+            util::SpriteSheet *sheet = nullptr;    // per-sheet texture path
+            const util::SheetArray *array = nullptr; // texture array path
+            std::size_t offset = 0;                  // bytes into buffer()
+            GLsizei count = 0;
+        };
+
+        explicit StaticSpriteBatch(uint8_t layer = 0) : m_layer(layer) {}
+        ~StaticSpriteBatch();
+
+        StaticSpriteBatch(const StaticSpriteBatch &) = delete;
+        StaticSpriteBatch &operator=(const StaticSpriteBatch &) = delete;
+
+        void add(util::SpriteSheet *sheet, const SpriteInstance &instance);
+
+        // Uploads everything added so far and drops the CPU copy.
+        void upload();
+
+        GLuint buffer() const noexcept { return m_buffer; }
+        const std::vector<Range> &ranges() const noexcept { return m_ranges; }
+        bool empty() const noexcept { return m_ranges.empty(); }
+
+        // Render layer every range of this batch sorts into.
+        uint8_t layer() const noexcept { return m_layer; }
+
+        void release();
+
+    private:
+        struct Staging
+        {
+            util::SpriteSheet *sheet = nullptr;
+            const util::SheetArray *array = nullptr;
+            std::vector<GpuSpriteInstance> instances;
+        };
+
+        // Ranges are built in the order their sheet or array was first added,
+        // so draw order never depends on pointer hashing.
+        std::vector<Staging> m_staging;
+        std::unordered_map<const void *, std::size_t> m_staging_index;
+
+        uint8_t m_layer = 0;
+
+        GLuint m_buffer{};
+        std::vector<Range> m_ranges;
+    };
+}
@@ -0,0 +1,202 @@
+#include "static_sprite_layer.hpp"
+
+#include <cmath>
+#include <limits>
+
+#include <glm/common.hpp>
+
+#include "util/profiler.hpp"
+
+namespace renderer
+{
+    StaticSpriteLayer::EntityId StaticSpriteLayer::add(util::SpriteSheet *sheet, const SpriteInstance &instance)
+    {
+        EntityId id = 0;
+        if (!m_free.empty())
+        {
+            id = m_free.back();
+            m_free.pop_back();
+        }
+        else
+        {
+            id = static_cast<EntityId>(m_entities.size());
+            m_entities.emplace_back();
+        }
+
+        Entity &e = m_entities[id];
+        e.sheet = sheet;
+        e.instance = instance;
+        link(id);
+        return id;
+    }
+
+    void StaticSpriteLayer::remove(EntityId id)
+    {
+        if (id >= m_entities.size() || !m_entities[id].sheet)
+        {
+            return;
+        }
+
+        unlink(id);
+        m_entities[id] = Entity{};
+        m_free.push_back(id);
+    }
+
+    void StaticSpriteLayer::set(EntityId id, util::SpriteSheet *sheet, const SpriteInstance &instance)
+    {
+        if (id >= m_entities.size() || !m_entities[id].sheet || !sheet)
+        {
+            return;
+        }
+
+        unlink(id);
+        m_entities[id].sheet = sheet;
+        m_entities[id].instance = instance;
+        link(id);
+    }
+
+    uint32_t StaticSpriteLayer::chunk_for(glm::vec2 pos)
+    {
+        const auto cx = static_cast<int32_t>(std::floor(pos.x / m_chunk_size));
+        const auto cy = static_cast<int32_t>(std::floor(pos.y / m_chunk_size));
+        const uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(cy)) << 32) | static_cast<uint32_t>(cx);
+
+        const auto [it, inserted] = m_chunk_lookup.try_emplace(key, static_cast<uint32_t>(m_chunks.size()));
+        if (inserted)
+        {
+            m_chunks.push_back(std::make_unique<Chunk>(m_layer));
+        }
+        return it->second;
+    }
+
+    void StaticSpriteLayer::link(EntityId id)
+    {
+        Entity &e = m_entities[id];
+        e.chunk = chunk_for(e.instance.pos);
+
+        Chunk &chunk = *m_chunks[e.chunk];
+        e.slot = static_cast<uint32_t>(chunk.entities.size());
+        chunk.entities.push_back(id);
+        chunk.dirty = true;
+    }
+
+    void StaticSpriteLayer::unlink(EntityId id)
+    {
+        const Entity &e = m_entities[id];
+        Chunk &chunk = *m_chunks[e.chunk];
+
+        // Swap-remove; the moved entity takes over the slot.
+        const EntityId moved = chunk.entities.back();
+        chunk.entities[e.slot] = moved;
+        m_entities[moved].slot = e.slot;
+        chunk.entities.pop_back();
+        chunk.dirty = true;
+    }
+
+    int StaticSpriteLayer::flush()
+    {
+        PROFILE_SCOPE("StaticSpriteLayer::flush");
+
+        int rebuilt = 0;
+
+        for (auto &chunk_ptr : m_chunks)
+        {
+            Chunk &chunk = *chunk_ptr;
+            if (!chunk.dirty)
+            {
+                continue;
+            }
+
+            constexpr float Inf = std::numeric_limits<float>::infinity();
+            util::Aabb bounds{glm::vec2(Inf), glm::vec2(-Inf)};
+
+            for (const EntityId id : chunk.entities)
+            {
+                const Entity &e = m_entities[id];
+                chunk.batch.add(e.sheet, e.instance);
+
+                bounds.min = glm::min(bounds.min, e.instance.pos);
+                bounds.max = glm::max(bounds.max, e.instance.pos + e.instance.size);
+            }
+
+            if (chunk.entities.empty())
+            {
+                chunk.batch.release();
+            }
+            else
+            {
+                chunk.batch.upload();
+            }
+
+            chunk.bounds = bounds;
+            chunk.dirty = false;
+            ++chunk.version;
+            m_grid_dirty = true;
+            ++rebuilt;
+        }
+
+        if (m_grid_dirty)
+        {
+            m_grid_chunks.clear();
+            m_chunk_bounds.clear();
+
+            for (std::size_t i = 0; i < m_chunks.size(); ++i)
+            {
+                if (!m_chunks[i]->entities.empty())
+                {
+                    m_grid_chunks.push_back(static_cast<uint32_t>(i));
+                    m_chunk_bounds.push_back(m_chunks[i]->bounds);
+                }
+            }
+
+            m_grid.build(m_chunk_bounds);
+            m_grid_dirty = false;
+        }
+
+        return rebuilt;
+    }
+
+    void StaticSpriteLayer::visible_chunks(const util::Aabb &view, std::vector<uint32_t> &chunks) const
+    {
+        m_visible_cells.clear();
+        m_grid.query(view, m_visible_cells);
+
+        // Grid cells and chunks share size and alignment, so each cell holds
+        // one chunk and the grid already tested its tight bounds.
+        for (const uint32_t cell : m_visible_cells)
+        {
+            for (const uint32_t item : m_grid.chunk_items(cell))
+            {
+                chunks.push_back(m_grid_chunks[item]);
+            }
+        }
+    }
+
+    int StaticSpriteLayer::submit_visible(SpriteRenderer &renderer, const util::Aabb &view)
+    {
+        m_visible.clear();
+        visible_chunks(view, m_visible);
+
+        for (const uint32_t chunk : m_visible)
+        {
+            renderer.submit_static(m_chunks[chunk]->batch);
+        }
+
+        return static_cast<int>(m_visible.size());
+    }
+
+    void StaticSpriteLayer::release()
+    {
+        for (auto &chunk : m_chunks)
+        {
+            chunk->batch.release();
+        }
+        m_chunks.clear();
+        m_chunk_lookup.clear();
+        m_entities.clear();
+        m_free.clear();
+        m_chunk_bounds.clear();
+        m_grid_chunks.clear();
+        m_grid.build({});
+    }
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "sprite_renderer.hpp"
+#include "static_sprite_batch.hpp"
+#include "util/spatial_grid.hpp"
+
+namespace renderer
+{
+    // Retained world geometry split into square chunks.
+    //
+    // Each chunk owns a StaticSpriteBatch (one GL_STATIC_DRAW buffer) that is
+    // rebuilt by flush() only after an entity in it was added, removed or
+    // changed; a frame just submits the batches of chunks in view. Pair with
+    // SpriteAnimated instances so animation needs no rebuilds. Sprites that
+    // move every frame belong in SpriteRenderer::submit instead.
+    class StaticSpriteLayer
+    {
+    public:
+        using EntityId = uint32_t;
+
+        explicit StaticSpriteLayer(float chunk_size = 512.0f, uint8_t layer = 0)
+            : m_chunk_size(chunk_size), m_layer(layer), m_grid(chunk_size) {}
+
+        StaticSpriteLayer(const StaticSpriteLayer &) = delete;
+        StaticSpriteLayer &operator=(const StaticSpriteLayer &) = delete;
+
+        EntityId add(util::SpriteSheet *sheet, const SpriteInstance &instance);
+        void remove(EntityId id);
+
+        // Replaces sheet and instance data; the entity may move to another chunk.
+        void set(EntityId id, util::SpriteSheet *sheet, const SpriteInstance &instance);
+
+        // Re-uploads dirty chunks; returns how many were rebuilt.
+        int flush();
+
+        // Submits every non-empty chunk intersecting `view`; returns the count.
+        // Call flush() first, the batches are drawn as last uploaded.
+        int submit_visible(SpriteRenderer &renderer, const util::Aabb &view);
+
+        // Appends the indices of non-empty chunks intersecting `view` (as of the last flush()).
+        void visible_chunks(const util::Aabb &view, std::vector<uint32_t> &chunks) const;
+
+        std::size_t chunk_count() const noexcept { return m_chunks.size(); }
+        const StaticSpriteBatch &chunk_batch(uint32_t chunk) const noexcept { return m_chunks[chunk]->batch; }
+        const util::Aabb &chunk_bounds(uint32_t chunk) const noexcept { return m_chunks[chunk]->bounds; }
+
+        // Bumped every time flush() rebuilds the chunk; caches of its content compare against it.
+        uint32_t chunk_version(uint32_t chunk) const noexcept { return m_chunks[chunk]->version; }
+
+        void release();
+
+    private:
+        struct Entity
+        {
+            util::SpriteSheet *sheet = nullptr; // nullptr = free slot
+            SpriteInstance instance{};
+            uint32_t chunk = 0;
+            uint32_t slot = 0; // index in Chunk::entities
+        };
+
+        struct Chunk
+        {
+            StaticSpriteBatch batch;
+            std::vector<EntityId> entities;
+            util::Aabb bounds{};
+            uint32_t version = 0;
+            bool dirty = false;
+
+            explicit Chunk(uint8_t layer) : batch(layer) {}
+        };
+
+        uint32_t chunk_for(glm::vec2 pos);
+        void link(EntityId id);
+        void unlink(EntityId id);
+
+        float m_chunk_size;
+        uint8_t m_layer;
+
+        std::vector<Entity> m_entities;
+        std::vector<EntityId> m_free;
+
+        std::vector<std::unique_ptr<Chunk>> m_chunks;
+        std::unordered_map<uint64_t, uint32_t> m_chunk_lookup; // packed (cx, cy) -> index
+
+        // One grid item per non-empty chunk (its tight bounds), rebuilt by
+        // flush() when any chunk changed.
+        util::SpatialGrid m_grid;
+        bool m_grid_dirty = false;
+        std::vector<uint32_t> m_grid_chunks; // grid item -> m_chunks index
+        std::vector<util::Aabb> m_chunk_bounds;
+        mutable std::vector<uint32_t> m_visible_cells;
+        std::vector<uint32_t> m_visible;
+    };
+}
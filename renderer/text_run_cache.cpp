@@ -0,0 +1,62 @@
+#include "text_run_cache.hpp"
+
+#include <cstring>
+
+#include "util/msdf_font.hpp"
+
+namespace renderer
+{
+    uint64_t TextRunCache::hash(const util::MsdfFont &font, std::string_view text, float scale) noexcept
+    {
+        // FNV-1a over the text, seeded with the font and scale.
+        uint32_t scale_bits = 0;
+        std::memcpy(&scale_bits, &scale, sizeof(scale_bits));
+
+        uint64_t h = 0xcbf29ce484222325ull ^ reinterpret_cast<std::uintptr_t>(&font) ^ (uint64_t(scale_bits) << 32);
+        for (const char c : text)
+        {
+            h ^= static_cast<unsigned char>(c);
+            h *= 0x100000001b3ull;
+        }
+        return h;
+    }
+
+    void TextRunCache::submit(SpriteRenderer &renderer, util::MsdfFont &font, std::string_view text,
+                              glm::vec2 pos, float scale, uint8_t layer)
+    {
+        Run &run = m_runs[hash(font, text, scale)];
+
+        if (run.font == &font && run.scale == scale && run.text == text)
+        {
+            ++m_hits;
+        }
+        else
+        {
+            // New key, or a collision: (re)build in place.
+            ++m_misses;
+            run.font = &font;
+            run.scale = scale;
+            run.text.assign(text);
+            run.glyphs.clear();
+            font.layout(text, scale, run.glyphs);
+        }
+
+        run.last_used = m_frame;
+        renderer.submit_glyphs(&font.sheet(), run.glyphs, pos, layer);
+    }
+
+    void TextRunCache::end_frame()
+    {
+        ++m_frame;
+
+        for (auto it = m_runs.begin(); it != m_runs.end();)
+        {
+            it = m_frame - it->second.last_used > m_max_idle_frames ? m_runs.erase(it) : std::next(it);
+        }
+    }
+
+    void TextRunCache::clear()
+    {
+        m_runs.clear();
+    }
+}
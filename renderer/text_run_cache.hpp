@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/vec2.hpp>
+
+#include "sprite_renderer.hpp"
+
+namespace util
+{
+    class MsdfFont;
+}
+
+namespace renderer
+{
+    // Laid-out text, so labels drawn every frame skip glyph lookup and packing.
+    //
+    // Runs are keyed by a hash of (font, scale, text) and hold packed glyph
+    // instances relative to the text's top-left corner; submit() queues a run
+    // at any position as one entry (SpriteRenderer::submit_glyphs). Runs not
+    // submitted for `max_idle_frames` end_frame() calls are dropped, so text
+    // that changes every frame cycles through without growing the cache.
+    class TextRunCache
+    {
+    public:
+        explicit TextRunCache(uint32_t max_idle_frames = 120) : m_max_idle_frames(max_idle_frames) {}
+
+        TextRunCache(const TextRunCache &) = delete;
+        TextRunCache &operator=(const TextRunCache &) = delete;
+
+        // Inside a Font batch. A hit neither allocates nor touches the glyph table.
+        void submit(SpriteRenderer &renderer, util::MsdfFont &font, std::string_view text,
+                    glm::vec2 pos, float scale = 1.0f, uint8_t layer = 0);
+
+        void end_frame();
+        void clear();
+
+        std::size_t size() const noexcept { return m_runs.size(); }
+        std::uint64_t hits() const noexcept { return m_hits; }
+        std::uint64_t misses() const noexcept { return m_misses; }
+
+    private:
+        struct Run
+        {
+            const util::MsdfFont *font = nullptr;
+            float scale = 0.0f;
+            std::string text; // resolves hash collisions
+            std::vector<GpuSpriteInstance> glyphs;
+            uint64_t last_used = 0;
+        };
+
+        static uint64_t hash(const util::MsdfFont &font, std::string_view text, float scale) noexcept;
+
+        std::unordered_map<uint64_t, Run> m_runs;
+        uint32_t m_max_idle_frames;
+        uint64_t m_frame = 0;
+
+        std::uint64_t m_hits = 0;
+        std::uint64_t m_misses = 0;
+    };
+}
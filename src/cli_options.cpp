@@ -0,0 +1,181 @@
+#include "cli_options.hpp"
+
+#include <charconv>
+#include <string_view>
+
+namespace
+{
+    template <typename T>
+    bool parse_number(std::string_view text, T &out)
+    {
+        const char *end = text.data() + text.size();
+        const auto [ptr, ec] = std::from_chars(text.data(), end, out);
+        return ec == std::errc{} && ptr == end;
+    }
+
+    bool parse_size(std::string_view text, int &width, int &height)
+    {
+        const auto x = text.find('x');
+        if (x == std::string_view::npos)
+        {
+            return false;
+        }
+        return parse_number(text.substr(0, x), width) && parse_number(text.substr(x + 1), height) &&
+               width > 0 && height > 0;
+    }
+
+    bool parse_pair(std::string_view text, float &x, float &y)
+    {
+        const auto comma = text.find(',');
+        if (comma == std::string_view::npos)
+        {
+            return false;
+        }
+        return parse_number(text.substr(0, comma), x) && parse_number(text.substr(comma + 1), y);
+    }
+}
+
+bool parse_cli_options(int argc, char **argv, CliOptions &options, std::string &error)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg = argv[i];
+
+        // Flags that take a value read it from the next argument.
+        const auto value = [&](std::string_view &out)
+        {
+            if (i + 1 >= argc)
+            {
+                error = std::string(arg) + " expects a value";
+                return false;
+            }
+            out = argv[++i];
+            return true;
+        };
+
+        std::string_view v;
+        if (arg == "--help" || arg == "-h")
+        {
+            options.help = true;
+        }
+        else if (arg == "--no-vsync")
+        {
+            options.vsync = false;
+        }
+        else if (arg == "--headless")
+        {
+            options.headless = true;
+        }
+        else if (arg == "--trim-report")
+        {
+            options.trim_report = true;
+        }
+        else if (arg == "--stats")
+        {
+            options.stats_overlay = true;
+        }
+        else if (arg == "--no-texture-arrays")
+        {
+            options.texture_arrays = false;
+        }
+        else if (arg == "--cpu-animation")
+        {
+            options.gpu_animation = false;
+        }
+        else if (arg == "--no-indirect")
+        {
+            options.multi_draw_indirect = false;
+        }
+        else if (arg == "--no-depth-sort")
+        {
+            options.depth_sorting = false;
+        }
+        else if (arg == "--sprites")
+        {
+            if (!value(v) || !parse_number(v, options.sprite_count) || options.sprite_count < 0)
+            {
+                error = error.empty() ? "bad --sprites value" : error;
+                return false;
+            }
+        }
+        else if (arg == "--cols")
+        {
+            if (!value(v) || !parse_number(v, options.columns) || options.columns <= 0)
+            {
+                error = error.empty() ? "bad --cols value" : error;
+                return false;
+            }
+        }
+        else if (arg == "--frames")
+        {
+            if (!value(v) || !parse_number(v, options.frames) || options.frames < 0)
+            {
+                error = error.empty() ? "bad --frames value" : error;
+                return false;
+            }
+        }
+        else if (arg == "--fixed-dt")
+        {
+            if (!value(v) || !parse_number(v, options.fixed_dt) || options.fixed_dt < 0.0)
+            {
+                error = error.empty() ? "bad --fixed-dt value" : error;
+                return false;
+            }
+        }
+        else if (arg == "--size")
+        {
+            if (!value(v) || !parse_size(v, options.width, options.height))
+            {
+                error = error.empty() ? "bad --size value (expected WxH)" : error;
+                return false;
+            }
+        }
+        else if (arg == "--zoom")
+        {
+            if (!value(v) || !parse_number(v, options.zoom) || !(options.zoom > 0.0f))
+            {
+                error = error.empty() ? "bad --zoom value" : error;
+                return false;
+            }
+        }
+        else if (arg == "--pan")
+        {
+            if (!value(v) || !parse_pair(v, options.pan_x, options.pan_y))
+            {
+                error = error.empty() ? "bad --pan value (expected X,Y)" : error;
+                return false;
+            }
+        }
+        else if (arg == "--glyph-font")
+        {
+            if (!value(v) || v.empty())
+            {
+                error = error.empty() ? "bad --glyph-font value" : error;
+                return false;
+            }
+            options.glyph_font = std::string(v);
+        }
+        else
+        {
+            error = "unknown option " + std::string(arg);
+            return false;
+        }
+    }
+
+    if (options.headless && options.frames == 0)
+    {
+        error = "--headless requires --frames";
+        return false;
+    }
+
+    return true;
+}
+
+const char *cli_usage()
+{
+    return "usage: game [--sprites N] [--cols N] [--frames N] [--no-vsync] [--fixed-dt S]\n"
+           "            [--headless] [--size WxH] [--zoom Z] [--pan X,Y]\n"
+           "            [--glyph-font FILE] [--trim-report] [--stats]\n"
+           "            [--no-texture-arrays] [--cpu-animation] [--no-indirect]\n"
+           "            [--no-depth-sort]\n";
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+
+// Command-line configuration for the demo and the benchmark runner.
+//
+//   --sprites N     sprite count (default 100000)
+//   --cols N        sprites per grid row (default 500)
+//   --frames N      exit after N frames and print throughput (0 = run until closed)
+//   --no-vsync      swap interval 0
+//   --fixed-dt S    advance the simulation clock by S seconds per frame
+//   --headless      offscreen EGL context, no window (requires --frames)
+//   --size WxH      framebuffer size (default 1280x720)
+//   --zoom Z        initial camera zoom, screen pixels per world pixel (default 1)
+//   --pan X,Y       scroll the camera by X,Y screen pixels per second, so
+//                   headless runs cross chunks (with --fixed-dt, reproducibly)
+//   --glyph-font F  TTF/OTF for glyphs missing from the prebuilt atlas,
+//                   rendered on demand (renderer::GlyphCache)
+//   --trim-report   print each sheet's trimmed coverage at startup
+//   --stats         GPU timer queries and a frame statistics overlay
+//
+// Renderer paths, all on by default; each flag falls back for comparison:
+//
+//   --no-texture-arrays  one texture per sheet instead of per-size-class arrays
+//   --cpu-animation      step frames per sprite on the CPU and stream instances
+//                        instead of retained chunks animated in the shader
+//   --no-indirect        glDrawArraysInstanced per run, no glMultiDrawArraysIndirect
+//   --no-depth-sort      no front-to-back opaque/cutout pass; everything blends
+struct CliOptions
+{
+    int sprite_count = 100000;
+    int columns = 500;
+    int frames = 0;
+    bool vsync = true;
+    double fixed_dt = 0.0;
+    bool headless = false;
+    int width = 1280;
+    int height = 720;
+    float zoom = 1.0f;
+    float pan_x = 0.0f;
+    float pan_y = 0.0f;
+    std::string glyph_font;
+    bool trim_report = false;
+    bool stats_overlay = false;
+
+    bool texture_arrays = true;
+    bool gpu_animation = true;
+    bool multi_draw_indirect = true;
+    bool depth_sorting = true;
+
+    bool help = false;
+};
+
+// Returns false and fills `error` on unknown flags or bad values.
+bool parse_cli_options(int argc, char **argv, CliOptions &options, std::string &error);
+
+const char *cli_usage();
@@ -0,0 +1,191 @@
+#include "headless_context.hpp"
+
+#include <cstring>
+
+#include <EGL/eglext.h>
+
+namespace
+{
+    bool has_egl_extension(EGLDisplay display, const char *name)
+    {
+        const char *extensions = eglQueryString(display, EGL_EXTENSIONS);
+        if (!extensions)
+        {
+            return false;
+        }
+
+        const std::size_t len = std::strlen(name);
+        for (const char *p = std::strstr(extensions, name); p; p = std::strstr(p + len, name))
+        {
+            if ((p == extensions || p[-1] == ' ') && (p[len] == ' ' || p[len] == '\0'))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    EGLDisplay open_display()
+    {
+        EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr))
+        {
+            return display;
+        }
+
+        // No default display (no X/Wayland): ask Mesa for a surfaceless one.
+        auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+            eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (!get_platform_display)
+        {
+            return EGL_NO_DISPLAY;
+        }
+
+        display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr))
+        {
+            return display;
+        }
+        return EGL_NO_DISPLAY;
+    }
+}
+
+HeadlessContext::~HeadlessContext()
+{
+    release();
+}
+
+bool HeadlessContext::create()
+{
+    m_display = open_display();
+    if (m_display == EGL_NO_DISPLAY || !eglBindAPI(EGL_OPENGL_API))
+    {
+        release();
+        return false;
+    }
+
+    const EGLint config_attribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_ALPHA_SIZE, 8,
+        EGL_NONE};
+
+    EGLConfig config = nullptr;
+    EGLint config_count = 0;
+    eglChooseConfig(m_display, config_attribs, &config, 1, &config_count);
+
+    const bool surfaceless = has_egl_extension(m_display, "EGL_KHR_surfaceless_context");
+    if (config_count < 1 && !(surfaceless && has_egl_extension(m_display, "EGL_KHR_no_config_context")))
+    {
+        release();
+        return false;
+    }
+
+    const EGLint context_attribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE};
+
+    m_context = eglCreateContext(m_display, config_count > 0 ? config : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, context_attribs);
+    if (m_context == EGL_NO_CONTEXT)
+    {
+        release();
+        return false;
+    }
+
+    // The pbuffer only makes the context current; we never draw to it.
+    if (config_count > 0)
+    {
+        const EGLint pbuffer_attribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+        m_surface = eglCreatePbufferSurface(m_display, config, pbuffer_attribs);
+    }
+
+    if (m_surface == EGL_NO_SURFACE && !surfaceless)
+    {
+        release();
+        return false;
+    }
+
+    if (!eglMakeCurrent(m_display, m_surface, m_surface, m_context))
+    {
+        release();
+        return false;
+    }
+
+    return true;
+}
+
+bool HeadlessContext::create_framebuffer(int width, int height)
+{
+    glGenRenderbuffers(1, &m_color);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+    glGenRenderbuffers(1, &m_depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &m_fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_color);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depth);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        return false;
+    }
+
+    glViewport(0, 0, width, height);
+    return true;
+}
+
+GLADapiproc HeadlessContext::get_proc_address(const char *name)
+{
+    return reinterpret_cast<GLADapiproc>(eglGetProcAddress(name));
+}
+
+void HeadlessContext::release()
+{
+    if (m_context != EGL_NO_CONTEXT)
+    {
+        if (m_fbo)
+        {
+            glDeleteFramebuffers(1, &m_fbo);
+            m_fbo = 0;
+        }
+        if (m_color)
+        {
+            glDeleteRenderbuffers(1, &m_color);
+            m_color = 0;
+        }
+        if (m_depth)
+        {
+            glDeleteRenderbuffers(1, &m_depth);
+            m_depth = 0;
+        }
+    }
+
+    if (m_display != EGL_NO_DISPLAY)
+    {
+        eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+        if (m_surface != EGL_NO_SURFACE)
+        {
+            eglDestroySurface(m_display, m_surface);
+        }
+        if (m_context != EGL_NO_CONTEXT)
+        {
+            eglDestroyContext(m_display, m_context);
+        }
+        eglTerminate(m_display);
+    }
+
+    m_display = EGL_NO_DISPLAY;
+    m_context = EGL_NO_CONTEXT;
+    m_surface = EGL_NO_SURFACE;
+}
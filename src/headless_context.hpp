@@ -0,0 +1,44 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <EGL/egl.h>
+
+// Offscreen GL 3.3 core context for machines without a display or GPU
+// (e.g. CI on Mesa llvmpipe).
+//
+// Uses a pbuffer config when the driver offers one, otherwise a surfaceless
+// context (EGL_KHR_surfaceless_context / EGL_MESA_platform_surfaceless).
+// Either way all rendering goes to an FBO of the requested size, which
+// stands in for the window's default framebuffer.
+class HeadlessContext
+{
+public:
+    HeadlessContext() = default;
+    ~HeadlessContext();
+
+    HeadlessContext(const HeadlessContext &) = delete;
+    HeadlessContext &operator=(const HeadlessContext &) = delete;
+
+    // Creates the context and makes it current.
+    bool create();
+
+    // After gladLoadGL: creates and binds the offscreen framebuffer.
+    bool create_framebuffer(int width, int height);
+
+    // Loader for gladLoadGL / renderer::load_gl_extensions.
+    static GLADapiproc get_proc_address(const char *name);
+
+    GLuint framebuffer() const noexcept { return m_fbo; }
+
+    void release();
+
+private:
+    EGLDisplay m_display = EGL_NO_DISPLAY;
+    EGLContext m_context = EGL_NO_CONTEXT;
+    EGLSurface m_surface = EGL_NO_SURFACE;
+
+    GLuint m_fbo{};
+    GLuint m_color{};
+    GLuint m_depth{};
+};
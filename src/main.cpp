@@ -3,79 +3,277 @@
 // Notes on performance:
 // - All JSON and sprite sheet creation happens once at startup.
 // - The hot loop does NOT do any unordered_map lookups or string hashing.
-// - The hot loop avoids per-sprite division/modulo for animation timing.
+// - The hot loop avoids per-sprite division/modulo for animation timing
+//   (util::step_frame).
 // - Sprite positions are precomputed once (no i%cols / i/cols each frame).
-// - Optional: sprites are submitted grouped-by-sheet to minimize texture/state changes.
+// - Sprites are bucketed into a chunked spatial grid; only chunks intersecting
+//   the camera view are visited, animated and submitted.
+//
+// Benchmarking: `game --headless --frames 600 --no-vsync --fixed-dt 0.016`
+// renders offscreen through EGL (no window or display needed) and prints
+// FPS, sprites/s and frame time percentiles at exit. See cli_options.hpp.
+//
+// Profiling: configure with -DGAME_PROFILER=ON for a CPU trace (Chrome trace
+// JSON) written to trace.json at exit, or at any time with F12.
 
 #include <glad/gl.h>
 #include <GLFW/glfw3.h>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <chrono>
+#include <cmath>
 #include <cstdint>
+#include <iostream>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 #include <random>
 
+#include "cli_options.hpp"
+#include "renderer/camera.hpp"
+#include "renderer/chunk_impostors.hpp"
+#include "renderer/gl_extensions.hpp"
+#include "renderer/glyph_cache.hpp"
 #include "renderer/sprite_renderer.hpp"
+#include "renderer/static_sprite_layer.hpp"
+#include "renderer/text_run_cache.hpp"
 #include "util/animation_library.hpp"
+#include "util/format_buffer.hpp"
 #include "util/fps_counter.hpp"
+#include "util/frame_stepper.hpp"
+#include "util/frame_time_stats.hpp"
 #include "util/msdf_font.hpp"
+#include "util/profiler.hpp"
+#include "util/sheet_array.hpp"
+#include "util/spatial_grid.hpp"
 #include "util/sprite_sheet.hpp"
 
+#ifdef GAME_HEADLESS_EGL
+#include "headless_context.hpp"
+#endif
+
 static void framebuffer_size_callback(GLFWwindow *, int w, int h)
 {
     glViewport(0, 0, w, h);
 }
 
+// Mouse wheel zooms around the cursor.
+static void scroll_callback(GLFWwindow *window, double, double yoffset)
+{
+    auto *camera = static_cast<renderer::Camera *>(glfwGetWindowUserPointer(window));
+    if (!camera)
+    {
+        return;
+    }
+
+    double x = 0.0, y = 0.0;
+    glfwGetCursorPos(window, &x, &y);
+    camera->zoom_at(std::pow(1.1f, static_cast<float>(yoffset)), {static_cast<float>(x), static_cast<float>(y)});
+}
+
+// Per-pass GPU times (from the previous frame) and this frame's counters.
+static void draw_stats_overlay(util::MsdfFont &font, renderer::SpriteRenderer &renderer, int fps, float x, float y)
+{
+    using Renderer = renderer::SpriteRenderer;
+    const Renderer::FrameStats &stats = renderer.frame_stats();
+
+    const auto &sprite = stats.gpu_ms[static_cast<std::size_t>(Renderer::BatchType::Sprite)];
+    const auto &text = stats.gpu_ms[static_cast<std::size_t>(Renderer::BatchType::Font)];
+
+    // The most expensive bucket (material and pass) of the frame.
+    const Renderer::GpuBucketTime *slowest = nullptr;
+    for (const Renderer::GpuBucketTime &bucket : stats.gpu_buckets)
+    {
+        if (!slowest || bucket.ms > slowest->ms)
+        {
+            slowest = &bucket;
+        }
+    }
+    static constexpr const char *pass_names[Renderer::PassCount] = {"base", "shadow", "mask", "night"};
+
+    // Every line changes most frames: formatted on the stack, laid out directly.
+    util::FormatBuffer<160> lines[5];
+    if (stats.gpu_stale)
+    {
+        lines[0].format("FPS: %d  GPU: (not ready)", fps);
+    }
+    else
+    {
+        lines[0].format("FPS: %d  GPU: %.2f ms", fps, stats.gpu_total_ms);
+    }
+    lines[1].format("sprite %.2f  shadow %.2f  mask %.2f  night %.2f  font %.2f ms",
+                    sprite[Renderer::BasePass], sprite[Renderer::ShadowPass], sprite[Renderer::MaskPass],
+                    sprite[Renderer::CompositePass], text[Renderer::BasePass]);
+    lines[2].format("draws %u  instances %llu  upload %.1f KB",
+                    stats.draw_calls, static_cast<unsigned long long>(stats.instances),
+                    static_cast<double>(stats.bytes_uploaded) / 1024.0);
+    lines[3].format("tex binds %u  blend %u  state %u (%u elided)",
+                    stats.texture_binds, stats.blend_changes, stats.state.issued, stats.state.elided);
+    if (slowest)
+    {
+        lines[4].format("slowest: material %u %s %.2f ms (%zu buckets)", static_cast<unsigned>(slowest->material),
+                        pass_names[slowest->pass], slowest->ms, stats.gpu_buckets.size());
+    }
+    else
+    {
+        lines[4].format("slowest: -");
+    }
+
+    const float line_step = font.line_height() * 1.25f;
+    for (const auto &line : lines)
+    {
+        font.render_text(renderer, line.view(), x, y, 1.0f);
+        y += line_step;
+    }
+}
+
 int main(int argc, char **argv)
 {
-    (void)argc;
-    (void)argv;
+    CliOptions options;
+    std::string cli_error;
+    if (!parse_cli_options(argc, argv, options, cli_error))
+    {
+        std::cerr << cli_error << '\n' << cli_usage();
+        return 1;
+    }
+    if (options.help)
+    {
+        std::cout << cli_usage();
+        return 0;
+    }
 
     FpsCounter fps_counter;
+    renderer::Camera camera;
+    camera.set_zoom(options.zoom);
 
     // -----------------------------
     // Window / GL init
     // -----------------------------
-    if (!glfwInit())
-    {
-        return 1;
-    }
+    // Headless runs never touch GLFW; the frame goes to an FBO instead.
+    GLFWwindow *window = nullptr;
+#ifdef GAME_HEADLESS_EGL
+    HeadlessContext headless;
+#endif
 
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    const auto shutdown = [&]()
+    {
+#ifdef GAME_HEADLESS_EGL
+        headless.release();
+#endif
+        if (window)
+        {
+            glfwDestroyWindow(window);
+            glfwTerminate();
+        }
+    };
 
-    GLFWwindow *window = glfwCreateWindow(1280, 720, "Instanced Sprites (GL 3.3)", nullptr, nullptr);
-    if (!window)
+    if (options.headless)
     {
-        glfwTerminate();
+#ifdef GAME_HEADLESS_EGL
+        if (!headless.create() || !gladLoadGL(HeadlessContext::get_proc_address))
+        {
+            std::cerr << "failed to create a headless EGL context\n";
+            shutdown();
+            return 1;
+        }
+        if (!headless.create_framebuffer(options.width, options.height))
+        {
+            std::cerr << "failed to create the offscreen framebuffer\n";
+            shutdown();
+            return 1;
+        }
+
+        renderer::load_gl_extensions(HeadlessContext::get_proc_address);
+#else
+        std::cerr << "built without EGL; --headless is unavailable\n";
         return 1;
+#endif
     }
+    else
+    {
+        if (!glfwInit())
+        {
+            return 1;
+        }
 
-    glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_DEPTH_BITS, 24);
 
-    // V-sync
-    glfwSwapInterval(1);
+        window = glfwCreateWindow(options.width, options.height, "Instanced Sprites (GL 3.3)", nullptr, nullptr);
+        if (!window)
+        {
+            glfwTerminate();
+            return 1;
+        }
 
-    if (!gladLoadGL((GLADloadfunc)glfwGetProcAddress))
-    {
-        glfwDestroyWindow(window);
-        glfwTerminate();
-        return 1;
+        glfwMakeContextCurrent(window);
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+        // WASD pans, the mouse wheel zooms.
+        glfwSetWindowUserPointer(window, &camera);
+        glfwSetScrollCallback(window, scroll_callback);
+
+        // V-sync
+        glfwSwapInterval(options.vsync ? 1 : 0);
+
+        if (!gladLoadGL((GLADloadfunc)glfwGetProcAddress))
+        {
+            shutdown();
+            return 1;
+        }
+
+        renderer::load_gl_extensions((GLADloadfunc)glfwGetProcAddress);
     }
 
     glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA); // premultiplied alpha
 
     // -----------------------------
     // Scene configuration
     // -----------------------------
-    const int sprite_count = 100000;
-    const int cols = 500;
+    const int sprite_count = options.sprite_count;
+    const int cols = options.columns;
+
+    // Pack sheets into per-size-class texture arrays so the sprite pass is one
+    // instanced draw per size class instead of one per sheet.
+    const bool use_texture_arrays = options.texture_arrays;
+
+    // Evaluate animation frames in the vertex shader from a time uniform and a
+    // retained instance buffer; the per-sprite CPU loop below is skipped.
+    const bool gpu_animation = options.gpu_animation;
+
+    // Submit with glMultiDrawArraysIndirect where the context supports it (GL 4.3);
+    // --no-indirect forces the per-run glDrawArraysInstanced path for comparison.
+    const bool use_multi_draw_indirect = options.multi_draw_indirect;
+
+    // Draw opaque and cutout sprites front to back with depth writes before
+    // blending the translucent rest; hidden pixels are never shaded.
+    const bool depth_sorting = options.depth_sorting;
+
+    // Per-pass GPU timer queries and draw counters, drawn over the scene;
+    // opt-in, so plain and headless runs time nothing.
+    const bool show_stats_overlay = options.stats_overlay;
+
+    // Chrome trace output of the CPU profiler (GAME_PROFILER builds only).
+    // Each dump (F12, and at exit) holds the zones since the previous one,
+    // so dumps are numbered: trace-1.json, trace-2.json, ...
+    int trace_dumps = 0;
+    const auto trace_path = [&]() { return "trace-" + std::to_string(++trace_dumps) + ".json"; };
+
+    // World-space edge of one spatial grid chunk.
+    const float chunk_size = 512.0f;
+
+    // Camera pan speed in screen pixels per second, and the scripted drift
+    // from --pan added to the keys.
+    const float pan_speed = 800.0f;
+    const glm::vec2 scripted_pan{options.pan_x, options.pan_y};
+
+    // Below this zoom, static chunks are drawn as one pre-rendered quad each.
+    const float impostor_zoom = 0.35f;
 
     // -----------------------------
     // Load animation definitions (JSON) once
@@ -117,6 +315,53 @@ int main(int argc, char **argv)
             false);
     }
 
+    // Fragments a trimmed quad still shades, relative to the full cell.
+    if (options.trim_report)
+    {
+        for (const auto &[key, sheet] : sheets_by_key)
+        {
+            std::cout << "trimmed " << key << ": " << static_cast<int>(sheet->trimmed_coverage() * 100.0f + 0.5f)
+                      << "% of cell area" << (sheet->has_shadow() || sheet->has_mask() ? " (overlays, untrimmed)" : "")
+                      << '\n';
+        }
+    }
+
+    std::vector<std::unique_ptr<util::SheetArray>> sheet_arrays;
+
+    if (use_texture_arrays)
+    {
+        std::vector<util::SpriteSheet *> sheet_ptrs;
+        sheet_ptrs.reserve(sheets_by_key.size());
+
+        for (auto &[key, sheet] : sheets_by_key)
+        {
+            (void)key;
+            sheet_ptrs.push_back(sheet.get());
+        }
+
+        sheet_arrays = util::build_sheet_arrays(sheet_ptrs);
+
+        // Packed sheets draw from their array; free the per-sheet copies.
+        for (util::SpriteSheet *sheet : sheet_ptrs)
+        {
+            if (sheet->array())
+            {
+                sheet->base_sprite().texture.release();
+                sheet->shadow_sprite().texture.release();
+                sheet->mask_sprite().texture.release();
+            }
+        }
+    }
+
+    // -----------------------------
+    // Renderer
+    // -----------------------------
+    // Created before flattening so sequences can be registered in its GPU table.
+    renderer::SpriteRenderer sprite_renderer(
+        renderer::InstanceRing::Mode::Persistent,
+        use_multi_draw_indirect ? renderer::DrawBackend::MultiDrawIndirect : renderer::DrawBackend::Direct);
+    sprite_renderer.set_depth_sorting(depth_sorting);
+
     // -----------------------------
     // Flatten animations into a list of runtime options
     // -----------------------------
@@ -126,6 +371,7 @@ int main(int argc, char **argv)
     {
         util::SpriteSheet *sheet = nullptr;
         const util::FrameSequence *sequence = nullptr;
+        uint16_t sequence_id = 0; // SequenceTable ID (gpu_animation)
     };
 
     std::vector<RuntimeAnim> runtime_anims;
@@ -139,16 +385,18 @@ int main(int argc, char **argv)
         for (const auto &[seq_name, seq] : def.sequences)
         {
             (void)seq_name; // sequence names are arbitrary; not needed at runtime here
-            runtime_anims.push_back(RuntimeAnim{sheet, &seq});
+            runtime_anims.push_back(RuntimeAnim{sheet, &seq, sprite_renderer.sequences().add(*sheet, seq)});
         }
     }
 
+    sprite_renderer.sequences().upload();
+    sprite_renderer.set_gpu_timing(show_stats_overlay);
+
     // Must have at least 1 animation sequence loaded.
     if (runtime_anims.empty())
     {
         // Nothing to display; clean shutdown.
-        glfwDestroyWindow(window);
-        glfwTerminate();
+        shutdown();
         return 1;
     }
 
@@ -179,6 +427,11 @@ int main(int argc, char **argv)
 
     std::mt19937 rng{std::random_device{}()};
 
+    // Retained instances for gpu_animation: one buffer per chunk, uploaded once;
+    // a frame only submits the chunks in view.
+    renderer::StaticSpriteLayer static_layer(chunk_size);
+    renderer::ChunkImpostors impostors;
+
     for (int i = 0; i < sprite_count; ++i)
     {
         const auto &ra = runtime_anims[static_cast<size_t>(i) % runtime_anims.size()];
@@ -206,140 +459,308 @@ int main(int argc, char **argv)
         }
 
         instances[i].frame_index = (frames_len[i] > 0) ? frames_ptr[i][0] : 0;
-        instances[i].frame_sequence = std::span<const unsigned int>(ra.sequence->frames);
-        instances[i].seconds_per_frame = ra.sequence->seconds_per_frame;
 
         // Precompute sprite position.
         const float x = static_cast<float>(i % cols) * tile_size;
         const float y = static_cast<float>(i / cols) * tile_size;
         positions[i] = {x, y};
+
+        if (gpu_animation)
+        {
+            // Start where the CPU path would; shared-clock sequences all start at 0.
+            const float phase = (ra.sequence->shared_clock || frames_len[i] == 0)
+                                    ? 0.0f
+                                    : static_cast<float>(frame_cursor[i]) / static_cast<float>(frames_len[i]);
+
+            static_layer.add(ra.sheet, renderer::SpriteInstance{
+                                           .pos = positions[i],
+                                           .size = {tile_size, tile_size},
+                                           .frame_index = ra.sequence_id,
+                                           .flags = renderer::SpriteAnimated,
+                                           .phase = phase,
+                                       });
+        }
+    }
+
+    if (gpu_animation)
+    {
+        static_layer.flush();
     }
 
     // -----------------------------
-    // Optional: group indices by sheet to minimize texture/state changes
+    // Spatial grid: sprite indices bucketed by chunk
     // -----------------------------
-    // If your SpriteRenderer breaks batches on texture changes, submitting mixed sheets
-    // will hurt. Grouping ensures we submit contiguous runs by sheet.
-    std::unordered_map<util::SpriteSheet *, std::vector<int>> sheet_to_indices;
-    sheet_to_indices.reserve(sheets_by_key.size());
-
+    // Visiting a chunk also catches its sprites' animation up from the last
+    // time it was on screen, so off-screen chunks cost nothing.
+    std::vector<util::Aabb> sprite_bounds(sprite_count);
     for (int i = 0; i < sprite_count; ++i)
     {
-        sheet_to_indices[instance_sheets[i]].push_back(i);
+        sprite_bounds[i] = {positions[i], positions[i] + glm::vec2(tile_size, tile_size)};
     }
 
+    util::SpatialGrid grid(chunk_size);
+    grid.build(sprite_bounds);
+
     // -----------------------------
-    // Renderer + font
+    // Clock
     // -----------------------------
-    renderer::SpriteRenderer sprite_renderer;
+    // With --fixed-dt the simulation advances a constant step per frame, so
+    // benchmark runs animate identically regardless of how fast they render.
+    const auto start_time = std::chrono::steady_clock::now();
+    const auto wall_time = [&]()
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    };
 
+    double sim_time = 0.0;
+    const auto frame_clock = [&]()
+    {
+        return options.fixed_dt > 0.0 ? sim_time : wall_time();
+    };
+
+    std::vector<double> chunk_anim_time(grid.chunk_count(), frame_clock());
+    std::vector<uint32_t> visible_chunks;
+
+    // -----------------------------
+    // Font
+    // -----------------------------
     util::MsdfFont font;
     font.load("assets/fonts/font.json", "assets/fonts/font.png");
     font.sheet().base_sprite().texture.set_filtering(GL_LINEAR, GL_LINEAR);
 
+    // Laid-out labels, reused while their text stays the same.
+    renderer::TextRunCache text_runs;
+
+    // Glyphs outside the prebuilt atlas, rendered on demand from --glyph-font.
+    renderer::GlyphCache glyph_cache;
+    if (!options.glyph_font.empty() && !glyph_cache.open(options.glyph_font))
+    {
+        std::cerr << "failed to open glyph font " << options.glyph_font << '\n';
+    }
+
     // Timing
-    double prev_time = glfwGetTime();
+    double prev_time = frame_clock();
+
+    // Throughput for --frames runs: wall time per frame and sprites in the sprite pass.
+    util::FrameTimeStats frame_times;
+    frame_times.reserve(static_cast<std::size_t>(options.frames));
+    std::uint64_t sprites_drawn = 0;
+    int frame_index = 0;
+    double frame_start = wall_time();
+
+    const auto running = [&]()
+    {
+        if (options.frames > 0 && frame_index >= options.frames)
+        {
+            return false;
+        }
+        return !window || !glfwWindowShouldClose(window);
+    };
 
     // -----------------------------
     // Main loop
     // -----------------------------
-    while (!glfwWindowShouldClose(window))
+    bool trace_key_down = false;
+
+    while (running())
     {
-        const double now = glfwGetTime();
+        PROFILE_SCOPE("frame");
+
+        const double now = frame_clock();
         fps_counter.tick(now);
 
         const double elapsed = now - prev_time;
         prev_time = now;
 
-        glfwPollEvents();
-
-        if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        int w = options.width, h = options.height;
+        if (window)
         {
-            glfwSetWindowShouldClose(window, GLFW_TRUE);
+            glfwPollEvents();
+
+            if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+            {
+                glfwSetWindowShouldClose(window, GLFW_TRUE);
+            }
+
+            const bool trace_key = glfwGetKey(window, GLFW_KEY_F12) == GLFW_PRESS;
+            if (trace_key && !trace_key_down)
+            {
+                (void)PROFILE_WRITE_TRACE(trace_path());
+            }
+            trace_key_down = trace_key;
+
+            glfwGetFramebufferSize(window, &w, &h);
         }
 
         glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        // Screen space, for the font pass.
+        const glm::mat4 proj = glm::ortho(0.0f, static_cast<float>(w), static_cast<float>(h), 0.0f);
 
+        // -----------------------------
+        // Camera
+        // -----------------------------
+        glm::vec2 pan{0.0f, 0.0f};
+        if (window)
+        {
+            if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) pan.x -= 1.0f;
+            if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) pan.x += 1.0f;
+            if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) pan.y -= 1.0f;
+            if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) pan.y += 1.0f;
+        }
 
-        int w = 0, h = 0;
-        glfwGetFramebufferSize(window, &w, &h);
+        camera.set_viewport({static_cast<float>(w), static_cast<float>(h)});
+        camera.pan((pan * pan_speed + scripted_pan) * static_cast<float>(elapsed));
 
-        const glm::mat4 proj = glm::ortho(0.0f, static_cast<float>(w), static_cast<float>(h), 0.0f);
+        const bool use_impostors = gpu_animation && camera.zoom() < impostor_zoom && impostors.available();
+        if (gpu_animation)
+        {
+            static_layer.flush(); // no-op unless entities changed
+        }
+        if (use_impostors)
+        {
+            // Renders into its own targets, so it runs before the sprite batch.
+            impostors.update(sprite_renderer, static_layer, camera.view_bounds(), now);
+        }
 
         // -----------------------------
         // Sprite pass
         // -----------------------------
-        sprite_renderer.begin_batch(proj, renderer::SpriteRenderer::BatchType::Sprite);
+        const std::uint64_t submitted_before = sprite_renderer.sprites_submitted();
 
-        const float dt = static_cast<float>(elapsed);
+        sprite_renderer.set_time(now);
+        sprite_renderer.begin_batch(camera.projection(), renderer::SpriteRenderer::BatchType::Sprite);
 
-        // Render grouped-by-sheet for fewer texture switches (often improves FPS).
-        for (auto &[sheet, idxs] : sheet_to_indices)
+        // GPU animation: the retained chunks animate themselves from the time uniform.
+        // update() may just have found impostors unsupported; fall back the same frame.
+        if (use_impostors && impostors.available())
         {
-            // Submit all sprites that use this sheet.
-            for (int idx : idxs)
-            {
-                // Advance animation using accumulator stepping:
-                // - No division
-                // - No modulo (wrap is a single compare)
-                anim_accum[idx] += dt;
+            impostors.submit_visible(sprite_renderer, static_layer, camera.view_bounds());
+        }
+        else if (gpu_animation)
+        {
+            static_layer.submit_visible(sprite_renderer, camera.view_bounds());
+        }
+        else
+        {
+            PROFILE_SCOPE("animate and submit chunks");
+
+            visible_chunks.clear();
+            grid.query(camera.view_bounds(), visible_chunks);
 
-                const float spf = seconds_per_frame[idx];
+            // Only chunks in view; the render queue groups by sheet afterwards.
+            for (const uint32_t chunk : visible_chunks)
+            {
+                // Time since this chunk was last animated (one frame while it stays in view).
+                const float dt = static_cast<float>(now - chunk_anim_time[chunk]);
+                chunk_anim_time[chunk] = now;
 
-                // Fast path: step at most one frame per tick (good for stable frame times).
-                if (anim_accum[idx] >= spf)
+                for (const uint32_t idx : grid.chunk_items(chunk))
                 {
-                    anim_accum[idx] -= spf;
-
-                    uint32_t c = frame_cursor[idx] + 1;
-                    if (c >= frames_len[idx])
-                    {
-                        c = 0;
-                    }
-                    frame_cursor[idx] = c;
-                }
+                    frame_cursor[idx] = util::step_frame(
+                        anim_accum[idx], frame_cursor[idx], dt, seconds_per_frame[idx], frames_len[idx]);
 
-                const unsigned int frame = frames_ptr[idx][frame_cursor[idx]];
-                instances[idx].frame_index = frame;
+                    const unsigned int frame = frames_ptr[idx][frame_cursor[idx]];
+                    instances[idx].frame_index = frame;
 
-                // Build draw instance (pos from precomputed array).
-                const glm::vec2 p = positions[idx];
+                    // Build draw instance (pos from precomputed array).
+                    // UVs are resolved on the GPU from the sheet's UV table.
+                    const glm::vec2 p = positions[idx];
 
-                renderer::SpriteInstance draw_instance{
-                    .pos = {p.x, p.y},
-                    .size = {tile_size, tile_size},
-                };
+                    renderer::SpriteInstance draw_instance{
+                        .pos = {p.x, p.y},
+                        .size = {tile_size, tile_size},
+                        .frame_index = frame,
+                    };
 
-                // Compute UV rect for current frame and submit.
-                draw_instance.uv = sheet->uv_rect_vec4(frame);
-                sprite_renderer.submit(sheet, draw_instance);
+                    sprite_renderer.submit(instance_sheets[idx], draw_instance);
+                }
             }
         }
 
         sprite_renderer.end_batch();
+        sprites_drawn += sprite_renderer.sprites_submitted() - submitted_before;
 
         // -----------------------------
         // Font pass
         // -----------------------------
+        glyph_cache.update();
+
         sprite_renderer.begin_batch(proj, renderer::SpriteRenderer::BatchType::Font);
 
-        font.render_text(
-            sprite_renderer,
-            &font.sheet(),
-            "FPS: " + std::to_string(fps_counter.fps),
-            10.0f,
-            10.0f,
-            1.0f);
+        if (show_stats_overlay)
+        {
+            draw_stats_overlay(font, sprite_renderer, fps_counter.fps, 10.0f, 10.0f);
+        }
+        else
+        {
+            // Changes once a second; every other frame is a cache hit.
+            util::FormatBuffer<32> label;
+            text_runs.submit(sprite_renderer, font, label.format("FPS: %d", fps_counter.fps), {10.0f, 10.0f});
+        }
+
+        if (glyph_cache.is_open())
+        {
+            // "Grüße · Привет · こんにちは", escaped so the source stays ASCII.
+            constexpr std::string_view sample =
+                "Gr\xC3\xBC\xC3\x9F" "e \xC2\xB7 "
+                "\xD0\x9F\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82 \xC2\xB7 "
+                "\xE3\x81\x93\xE3\x82\x93\xE3\x81\xAB\xE3\x81\xA1\xE3\x81\xAF";
+            glyph_cache.render_text(sprite_renderer, sample,
+                                    {10.0f, static_cast<float>(h) - 10.0f - glyph_cache.line_height() * 1.25f});
+        }
 
         sprite_renderer.end_batch();
+        text_runs.end_frame();
+        sprite_renderer.end_frame();
+
+        if (window)
+        {
+            PROFILE_SCOPE("glfwSwapBuffers");
+            glfwSwapBuffers(window);
+        }
+        else
+        {
+            PROFILE_SCOPE("glFinish");
 
-        glfwSwapBuffers(window);
+            // No swap to pace against; wait for the GPU so frame times are real.
+            glFinish();
+        }
+
+        const double frame_end = wall_time();
+        frame_times.add(frame_end - frame_start);
+        frame_start = frame_end;
+
+        sim_time += options.fixed_dt;
+        ++frame_index;
+    }
+
+    if (options.frames > 0 && frame_times.total() > 0.0)
+    {
+        const double seconds = frame_times.total();
+        std::cout << "frames: " << frame_times.count()
+                  << "  time: " << seconds << " s"
+                  << "  fps: " << static_cast<double>(frame_times.count()) / seconds
+                  << "  sprites/s: " << static_cast<double>(sprites_drawn) / seconds << '\n'
+                  << "frame time (ms)  p50: " << frame_times.percentile(50.0) * 1000.0
+                  << "  p95: " << frame_times.percentile(95.0) * 1000.0
+                  << "  p99: " << frame_times.percentile(99.0) * 1000.0 << '\n';
+
+        const auto &stats = sprite_renderer.frame_stats();
+        std::cout << "last frame  draws: " << stats.draw_calls
+                  << "  instances: " << stats.instances
+                  << "  uploaded: " << stats.bytes_uploaded << " B"
+                  << "  gpu: " << stats.gpu_total_ms << " ms\n";
     }
 
+    (void)PROFILE_WRITE_TRACE(trace_path());
+
     // -----------------------------
     // Cleanup / release
     // -----------------------------
+    impostors.release();
+    static_layer.release();
     sprite_renderer.release();
 
     // Release all textures created for sheets loaded from JSON.
@@ -349,12 +770,22 @@ int main(int argc, char **argv)
         sheet->base_sprite().texture.release();
         sheet->mask_sprite().texture.release();
         sheet->shadow_sprite().texture.release();
+        sheet->uv_table().release();
+        sheet->trim_table().release();
+    }
+
+    // Release texture arrays built from those sheets.
+    for (auto &array : sheet_arrays)
+    {
+        array->release();
     }
 
     // Release font texture.
     font.sheet().base_sprite().texture.release();
+    font.sheet().uv_table().release();
+    font.sheet().trim_table().release();
+    glyph_cache.release();
 
-    glfwDestroyWindow(window);
-    glfwTerminate();
+    shutdown();
     return 0;
 }
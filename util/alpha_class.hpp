@@ -0,0 +1,55 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace util
+{
+    // How a sprite frame covers its quad, worst case over its texels.
+    // - Opaque:      every texel fully opaque; no blending needed
+    // - Cutout:      texels are fully opaque or fully transparent; alpha-tested
+    // - Translucent: partial alpha somewhere; must blend back to front
+    // Ordered so the "worse" class compares greater.
+    enum class AlphaClass : uint8_t
+    {
+        Opaque,
+        Cutout,
+        Translucent
+    };
+
+    inline AlphaClass worst(AlphaClass a, AlphaClass b) noexcept
+    {
+        return std::max(a, b);
+    }
+
+    // Classifies a w x h rect of tightly packed RGBA8 pixels (row length
+    // `stride` pixels) by alpha alone; sprite textures are color keyed at
+    // load (TextureAlpha::Premultiplied). Alpha within `tolerance` of 0 or
+    // 255 is treated as binary.
+    inline AlphaClass classify_alpha(const unsigned char *rgba, std::size_t stride, int x, int y, int w, int h,
+                                     int tolerance = 3)
+    {
+        AlphaClass result = AlphaClass::Opaque;
+
+        for (int row = 0; row < h; ++row)
+        {
+            const unsigned char *p = rgba + ((static_cast<std::size_t>(y + row) * stride) + static_cast<std::size_t>(x)) * 4;
+            for (int col = 0; col < w; ++col, p += 4)
+            {
+                const int a = p[3];
+
+                if (a > tolerance && a < 255 - tolerance)
+                {
+                    return AlphaClass::Translucent;
+                }
+                if (a <= tolerance)
+                {
+                    result = AlphaClass::Cutout;
+                }
+            }
+        }
+
+        return result;
+    }
+}
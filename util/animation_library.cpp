@@ -1,4 +1,5 @@
 #include "util/animation_library.hpp"
+#include "util/profiler.hpp"
 
 #include <filesystem>
 #include <fstream>
@@ -59,6 +60,12 @@ namespace util
 
             FrameSequence seq;
             seq.seconds_per_frame = seq_obj.at("secondsPerFrame").get<double>();
+            if (!(seq.seconds_per_frame > 0.0))
+            {
+                throw std::runtime_error(
+                    "secondsPerFrame must be positive in sequence '" + seq_name + "' in: " + path.string());
+            }
+            seq.shared_clock = seq_obj.value("sharedClock", false);
 
             const auto &frames = seq_obj.at("frames");
             if (!frames.is_array())
@@ -81,6 +88,8 @@ namespace util
 
     AnimationLibrary load_animation_library(const std::string &directory)
     {
+        PROFILE_SCOPE("load_animation_library");
+
         AnimationLibrary lib;
 
         const fs::path dir_path{directory};
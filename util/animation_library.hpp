@@ -10,6 +10,10 @@ namespace util
     {
         std::vector<unsigned int> frames;
         double seconds_per_frame = 0.1;
+
+        // All instances run in lockstep on one global clock (e.g. belts)
+        // instead of each starting at its own phase.
+        bool shared_clock = false;
     };
 
     struct AnimationDef
@@ -1,5 +1,3 @@
-#include <msdfgen.h>
-#include <msdfgen-ext.h>
 #include <filesystem>
 
 #include <ft2build.h>
@@ -8,23 +6,184 @@
 #include <png.h>
 #include <nlohmann/json.hpp>
 
+#include "util/glyph_rasterizer.hpp"
+#include "util/utf8.hpp"
+
 #include <vector>
 #include <string>
+#include <string_view>
 #include <fstream>
 #include <iostream>
-#include <unordered_map>
+#include <sstream>
+#include <charconv>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <climits>
 #include <cmath>
 #include <algorithm>
 
 using json = nlohmann::json;
 
+// Offline MSDF atlas baker for util::MsdfFont.
+//
+//   atlas_generator [options] font.ttf
+//     --charset FILE   UTF-8 text; every code point in it is baked
+//                      (default: printable ASCII and Latin-1)
+//     --size PX        glyph pixel height, roughly the EM (default 48)
+//     --pxrange PX     distance field range in pixels (default 6)
+//     --max-size N     largest page edge, a power of two (default 4096)
+//     --threads N      rasterizer threads (default: all cores)
+//     --out DIR        output directory (default assets/fonts)
+//     --name NAME      output base name (default font)
+//
+// Glyphs are rasterised in parallel, one util::GlyphRasterizer (FreeType
+// face plus msdfgen font handle) per thread, then packed with MaxRects into
+// the smallest power-of-two page that holds them. Charsets that overflow
+// --max-size spill onto further pages: NAME_0.png, NAME_1.png, ... listed
+// under "pages" in NAME.json; each glyph records its page.
+
+struct Options
+{
+    std::string fontPath;
+    std::string charsetPath;
+    int glyphPxHeight = 48;
+    int rangePx = 6;
+    int maxSize = 4096;
+    int threads = 0;
+    std::string outDir = "assets/fonts";
+    std::string name = "font";
+};
+
+struct Rect
+{
+    int x, y, w, h;
+};
+
 struct Glyph
 {
-    float advance;
-    float bearingX;
-    float bearingY;
-    int w, h;
-    int x, y; // atlas position in pixels
+    util::RasterGlyph raster;
+    FT_UInt index = 0; // FreeType glyph index, for kerning lookups
+    int page = -1;
+    int x = 0, y = 0;  // page position in pixels
+};
+
+struct Page
+{
+    int width = 0;
+    int height = 0;
+    std::vector<size_t> glyphs;
+};
+
+// Texels between glyphs; each bitmap already carries its range border.
+static const int padding = 1;
+
+// MaxRects bin packing, best-short-side-fit: keeps every maximal free
+// rectangle and places each glyph where it leaves the smallest leftover edge.
+class MaxRectsPacker
+{
+public:
+    MaxRectsPacker(int width, int height)
+    {
+        m_free.push_back({0, 0, width, height});
+    }
+
+    bool insert(int w, int h, int &x, int &y)
+    {
+        const Rect *best = nullptr;
+        int bestShort = INT_MAX;
+        int bestLong = INT_MAX;
+        for (const Rect &r : m_free)
+        {
+            if (w > r.w || h > r.h)
+                continue;
+
+            const int leftoverX = r.w - w;
+            const int leftoverY = r.h - h;
+            const int shortSide = std::min(leftoverX, leftoverY);
+            const int longSide = std::max(leftoverX, leftoverY);
+            if (shortSide < bestShort || (shortSide == bestShort && longSide < bestLong))
+            {
+                best = &r;
+                bestShort = shortSide;
+                bestLong = longSide;
+            }
+        }
+
+        if (!best)
+            return false;
+
+        const Rect placed{best->x, best->y, w, h};
+        x = placed.x;
+        y = placed.y;
+        split(placed);
+        return true;
+    }
+
+private:
+    static bool intersects(const Rect &a, const Rect &b)
+    {
+        return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+    }
+
+    static bool contains(const Rect &outer, const Rect &inner)
+    {
+        return inner.x >= outer.x && inner.y >= outer.y &&
+               inner.x + inner.w <= outer.x + outer.w && inner.y + inner.h <= outer.y + outer.h;
+    }
+
+    // Replaces every free rect the placed one overlaps with the (up to four)
+    // maximal rects around it, then drops free rects inside another.
+    void split(const Rect &placed)
+    {
+        m_kept.clear();
+        m_new.clear();
+
+        for (const Rect &r : m_free)
+        {
+            if (!intersects(r, placed))
+            {
+                m_kept.push_back(r);
+                continue;
+            }
+
+            if (placed.x > r.x)
+                m_new.push_back({r.x, r.y, placed.x - r.x, r.h});
+            if (placed.x + placed.w < r.x + r.w)
+                m_new.push_back({placed.x + placed.w, r.y, r.x + r.w - (placed.x + placed.w), r.h});
+            if (placed.y > r.y)
+                m_new.push_back({r.x, r.y, r.w, placed.y - r.y});
+            if (placed.y + placed.h < r.y + r.h)
+                m_new.push_back({r.x, placed.y + placed.h, r.w, r.y + r.h - (placed.y + placed.h)});
+        }
+
+        // New rects are few; only they can contain, or be contained by,
+        // another free rect.
+        for (size_t i = 0; i < m_new.size(); ++i)
+        {
+            bool redundant = false;
+            for (size_t j = 0; j < m_new.size() && !redundant; ++j)
+            {
+                // Of two equal rects keep the first.
+                redundant = j != i && contains(m_new[j], m_new[i]) && (j < i || !contains(m_new[i], m_new[j]));
+            }
+            for (size_t j = 0; j < m_kept.size() && !redundant; ++j)
+            {
+                redundant = contains(m_kept[j], m_new[i]);
+            }
+            if (redundant)
+                continue;
+
+            std::erase_if(m_kept, [&](const Rect &k) { return contains(m_new[i], k); });
+            m_kept.push_back(m_new[i]);
+        }
+
+        m_free.swap(m_kept);
+    }
+
+    std::vector<Rect> m_free;
+    std::vector<Rect> m_kept; // split() scratch
+    std::vector<Rect> m_new;
 };
 
 static void SavePNG(const char *path, int w, int h, const std::vector<unsigned char> &rgba)
@@ -82,205 +241,356 @@ static void SavePNG(const char *path, int w, int h, const std::vector<unsigned c
     fclose(fp);
 }
 
-int main(int argc, char **argv)
+static void PrintUsage()
 {
-    if (argc < 2)
-    {
-        std::cerr << "Usage: atlas_generator font.ttf\n";
-        return 1;
-    }
-
-    const int firstChar = 32;
-    const int lastChar = 126;
-
-    const int glyphPxHeight = 48; // target height in pixels (roughly EM height)
-    const int rangePx = 6;        // SDF range in pixels
-    const int atlasSize = 1024;
+    std::cerr << "Usage: atlas_generator [--charset FILE] [--size PX] [--pxrange PX] [--max-size N]\n"
+                 "                       [--threads N] [--out DIR] [--name NAME] font.ttf\n";
+}
 
-    // ---- FreeType for metrics (advance/bearing) ----
-    FT_Library ftLib = nullptr;
-    if (FT_Init_FreeType(&ftLib))
-    {
-        std::cerr << "FT_Init_FreeType failed\n";
-        return 1;
-    }
+static bool ParseInt(std::string_view text, int &out)
+{
+    const auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), out);
+    return ec == std::errc{} && ptr == text.data() + text.size();
+}
 
-    FT_Face face = nullptr;
-    if (FT_New_Face(ftLib, argv[1], 0, &face))
+static bool ParseOptions(int argc, char **argv, Options &options)
+{
+    for (int i = 1; i < argc; ++i)
     {
-        std::cerr << "FT_New_Face failed: " << argv[1] << "\n";
-        FT_Done_FreeType(ftLib);
-        return 1;
+        const std::string_view arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (arg == "--charset" && hasValue)
+            options.charsetPath = argv[++i];
+        else if (arg == "--size" && hasValue && ParseInt(argv[i + 1], options.glyphPxHeight) && options.glyphPxHeight > 0)
+            ++i;
+        else if (arg == "--pxrange" && hasValue && ParseInt(argv[i + 1], options.rangePx) && options.rangePx > 0)
+            ++i;
+        else if (arg == "--max-size" && hasValue && ParseInt(argv[i + 1], options.maxSize) &&
+                 options.maxSize >= 64 && (options.maxSize & (options.maxSize - 1)) == 0)
+            ++i;
+        else if (arg == "--threads" && hasValue && ParseInt(argv[i + 1], options.threads) && options.threads > 0)
+            ++i;
+        else if (arg == "--out" && hasValue)
+            options.outDir = argv[++i];
+        else if (arg == "--name" && hasValue)
+            options.name = argv[++i];
+        else if (!arg.starts_with("--") && options.fontPath.empty())
+            options.fontPath = arg;
+        else
+        {
+            std::cerr << "Bad argument: " << arg << "\n";
+            return false;
+        }
     }
+    return !options.fontPath.empty();
+}
 
-    FT_Set_Pixel_Sizes(face, 0, glyphPxHeight);
-    double pxPerUnit = 0.0;
+// Code points to bake, sorted and unique. Space and '?' (MsdfFont's
+// fallback) are always included.
+static bool LoadCharset(const std::string &path, std::vector<char32_t> &out)
+{
+    out = {U' ', U'?'};
 
-    // ---- msdfgen for outlines ----
-    msdfgen::FreetypeHandle *msft = msdfgen::initializeFreetype();
-    msdfgen::FontHandle *font = msdfgen::loadFont(msft, argv[1]);
-    if (!font)
+    if (path.empty())
     {
-        std::cerr << "msdfgen::loadFont failed\n";
-        FT_Done_Face(face);
-        FT_Done_FreeType(ftLib);
-        msdfgen::deinitializeFreetype(msft);
-        return 1;
+        for (char32_t c = 32; c <= 126; ++c)
+            out.push_back(c);
+        for (char32_t c = 160; c <= 255; ++c)
+            out.push_back(c);
     }
-
-    auto CalibrateScale = [&](int c) -> bool
+    else
     {
-        if (FT_Load_Char(face, (FT_ULong)c, FT_LOAD_NO_BITMAP))
+        std::ifstream f(path, std::ios::binary);
+        if (!f.is_open())
             return false;
 
-        msdfgen::Shape shape;
-        if (!msdfgen::loadGlyph(shape, font, c))
-            return false;
+        std::stringstream buffer;
+        buffer << f.rdbuf();
+        const std::string text = buffer.str();
 
-        msdfgen::edgeColoringSimple(shape, 3.0);
+        for (size_t i = 0; i < text.size();)
+        {
+            const char32_t c = util::next_code_point(text, i);
+            // Line breaks, tabs, BOM and malformed bytes are not glyphs.
+            if (c >= 32 && c != 0x7F && c != 0xFEFF && c != util::ReplacementChar)
+                out.push_back(c);
+        }
+    }
 
-        const auto b = shape.getBounds();
-        const double msdfH = (b.t - b.b);
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+    return true;
+}
 
-        // FreeType glyph height in pixels
-        const double ftH = face->glyph->metrics.height / 64.0;
+static int NextPowerOfTwo(int v)
+{
+    int p = 1;
+    while (p < v)
+        p <<= 1;
+    return p;
+}
 
-        if (!(msdfH > 0.0) || !(ftH > 0.0))
+// Packs `order` into a width x height page, padded. With `partial`, glyphs
+// that don't fit go to `rest`; otherwise the first miss fails the page.
+static bool PackPage(std::vector<Glyph> &glyphs, const std::vector<size_t> &order, int width, int height,
+                     bool partial, Page &page, std::vector<size_t> &rest)
+{
+    MaxRectsPacker packer(width - padding, height - padding);
+    page = Page{width, height, {}};
+    rest.clear();
+
+    for (const size_t i : order)
+    {
+        Glyph &g = glyphs[i];
+        int x = 0, y = 0;
+        if (packer.insert(g.raster.width + padding, g.raster.height + padding, x, y))
+        {
+            g.x = x + padding;
+            g.y = y + padding;
+            page.glyphs.push_back(i);
+        }
+        else if (partial)
+            rest.push_back(i);
+        else
             return false;
+    }
+    return true;
+}
 
-        pxPerUnit = ftH / msdfH;
-        std::cerr << "Calibrated pxPerUnit=" << pxPerUnit
-                  << " (ftH=" << ftH << ", msdfH=" << msdfH << ")\n";
-        return true;
-    };
+// Smallest power-of-two page (w x h with h = w or w / 2) holding all of
+// `order`, or false if even maxSize x maxSize is too small.
+static bool PackSmallest(std::vector<Glyph> &glyphs, const std::vector<size_t> &order, int maxSize, Page &page)
+{
+    long long area = 0;
+    int widest = 0;
+    for (const size_t i : order)
+    {
+        const Glyph &g = glyphs[i];
+        area += (long long)(g.raster.width + padding) * (g.raster.height + padding);
+        widest = std::max({widest, g.raster.width + 2 * padding, g.raster.height + 2 * padding});
+    }
 
-    if (!CalibrateScale('M') && !CalibrateScale('H') && !CalibrateScale('A'))
+    std::vector<size_t> rest;
+    int size = std::max(64, NextPowerOfTwo(std::max(widest, (int)std::ceil(std::sqrt((double)area)))));
+    for (; size <= maxSize; size *= 2)
     {
-        std::cerr << "Failed to calibrate scale\n";
+        if ((long long)size * (size / 2) >= area && PackPage(glyphs, order, size, size / 2, false, page, rest))
+            return true;
+        if (PackPage(glyphs, order, size, size, false, page, rest))
+            return true;
+    }
+    return false;
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        PrintUsage();
         return 1;
     }
 
-    std::unordered_map<int, Glyph> glyphs;
-    std::vector<unsigned char> atlas(atlasSize * atlasSize * 4, 0);
+    std::vector<char32_t> charset;
+    if (!LoadCharset(options.charsetPath, charset))
+    {
+        std::cerr << "Failed to read charset " << options.charsetPath << "\n";
+        return 1;
+    }
 
-    int penX = rangePx;
-    int penY = rangePx;
-    int rowH = 0;
+    const auto start = std::chrono::steady_clock::now();
 
-    for (int c = firstChar; c <= lastChar; ++c)
+    // ---- FreeType on this thread: glyph indices and kerning ----
+    FT_Library ftLib = nullptr;
+    if (FT_Init_FreeType(&ftLib))
     {
-        // Load glyph in FreeType to get metrics
-        if (FT_Load_Char(face, (FT_ULong)c, FT_LOAD_NO_BITMAP))
-            continue;
+        std::cerr << "FT_Init_FreeType failed\n";
+        return 1;
+    }
+
+    FT_Face face = nullptr;
+    if (FT_New_Face(ftLib, options.fontPath.c_str(), 0, &face))
+    {
+        std::cerr << "FT_New_Face failed: " << options.fontPath << "\n";
+        FT_Done_FreeType(ftLib);
+        return 1;
+    }
+    FT_Set_Pixel_Sizes(face, 0, options.glyphPxHeight);
 
-        msdfgen::Shape shape;
-        if (!msdfgen::loadGlyph(shape, font, c))
+    // Skip code points the font doesn't cover rather than baking .notdef
+    std::vector<Glyph> glyphs;
+    for (const char32_t c : charset)
+    {
+        const FT_UInt glyphIndex = FT_Get_Char_Index(face, (FT_ULong)c);
+        if (glyphIndex == 0)
             continue;
 
-        // shape.normalize();
-        msdfgen::edgeColoringSimple(shape, 3.0);
+        Glyph g;
+        g.raster.codepoint = c;
+        g.index = glyphIndex;
+        glyphs.push_back(std::move(g));
+    }
 
-        msdfgen::Shape::Bounds b = shape.getBounds();
+    // ---- Rasterise: one FreeType/msdfgen handle per thread ----
+    const int threadCount = std::max(1, options.threads > 0 ? options.threads : (int)std::thread::hardware_concurrency());
+    std::atomic<size_t> next{0};
+    std::atomic<bool> openFailed{false};
 
-        // Convert shape bounds (font units) -> pixels using pxPerUnit
-        const double wPx = (b.r - b.l) * pxPerUnit;
-        const double hPx = (b.t - b.b) * pxPerUnit;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threadCount; ++t)
+    {
+        workers.emplace_back([&]
+        {
+            util::GlyphRasterizer rasterizer;
+            if (!rasterizer.open(options.fontPath, options.glyphPxHeight, options.rangePx))
+            {
+                openFailed = true;
+                return;
+            }
 
-        int gw = int(std::ceil(wPx)) + rangePx * 2;
-        int gh = int(std::ceil(hPx)) + rangePx * 2;
+            for (size_t i = next++; i < glyphs.size(); i = next++)
+            {
+                const char32_t c = glyphs[i].raster.codepoint;
+                rasterizer.rasterize(c, glyphs[i].raster);
+            }
+        });
+    }
+    for (auto &worker : workers)
+        worker.join();
 
-        static int maxGW = 0, maxGH = 0;
-        maxGW = std::max(maxGW, gw);
-        maxGH = std::max(maxGH, gh);
-        if (c == lastChar)
-        {
-            std::cerr << "maxGW=" << maxGW << " maxGH=" << maxGH << "\n";
-        }
+    if (openFailed)
+    {
+        std::cerr << "Failed to load or calibrate " << options.fontPath << "\n";
+        FT_Done_Face(face);
+        FT_Done_FreeType(ftLib);
+        return 1;
+    }
 
-        if (gw <= 0 || gh <= 0)
-            continue;
+    std::erase_if(glyphs, [](const Glyph &g) { return !g.raster.found; });
 
-        if (penX + gw >= atlasSize)
+    int maxGW = 0, maxGH = 0;
+    for (const Glyph &g : glyphs)
+    {
+        maxGW = std::max(maxGW, g.raster.width);
+        maxGH = std::max(maxGH, g.raster.height);
+    }
+    std::cerr << "glyphs=" << glyphs.size() << " maxGW=" << maxGW << " maxGH=" << maxGH
+              << " threads=" << threadCount << "\n";
+
+    // ---- Pack: tallest first, smallest page that fits, spill when full ----
+    std::vector<size_t> order(glyphs.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b)
+    {
+        const auto &ra = glyphs[a].raster;
+        const auto &rb = glyphs[b].raster;
+        return ra.height != rb.height ? ra.height > rb.height : ra.width > rb.width;
+    });
+
+    std::vector<Page> pages;
+    std::vector<size_t> rest;
+    while (!order.empty())
+    {
+        Page page;
+        if (PackSmallest(glyphs, order, options.maxSize, page))
         {
-            penX = rangePx;
-            penY += rowH + rangePx;
-            rowH = 0;
+            pages.push_back(std::move(page));
+            break;
         }
 
-        if (penY + gh >= atlasSize)
+        PackPage(glyphs, order, options.maxSize, options.maxSize, true, page, rest);
+        if (page.glyphs.empty())
         {
-            std::cerr << "Atlas full; increase atlasSize\n";
+            std::cerr << "Glyphs larger than --max-size " << options.maxSize << "; dropping " << rest.size() << "\n";
             break;
         }
+        pages.push_back(std::move(page));
+        order.swap(rest);
+    }
 
-        msdfgen::Bitmap<float, 4> bmp(gw, gh);
+    for (size_t p = 0; p < pages.size(); ++p)
+    {
+        for (const size_t i : pages[p].glyphs)
+            glyphs[i].page = (int)p;
+    }
 
-        // Transform: shapeCoord * scale + translate = pixelCoord
-        const msdfgen::Vector2 scale(pxPerUnit, pxPerUnit);
-        const msdfgen::Vector2 translate(
-            rangePx - b.l * pxPerUnit,
-            rangePx - b.b * pxPerUnit);
+    // ---- Write pages and metrics ----
+    std::filesystem::create_directories(options.outDir);
+    const std::filesystem::path outDir = options.outDir;
 
-        msdfgen::generateMTSDF(bmp, shape, rangePx, scale, translate);
+    json j;
+    j["atlasSize"] = pages.empty() ? 0 : std::max(pages[0].width, pages[0].height);
+    j["pages"] = json::array();
+
+    for (size_t p = 0; p < pages.size(); ++p)
+    {
+        const Page &page = pages[p];
+        const std::string file = pages.size() == 1 ? options.name + ".png"
+                                                   : options.name + "_" + std::to_string(p) + ".png";
 
-        for (int y = 0; y < gh; ++y)
+        std::vector<unsigned char> atlas((size_t)page.width * page.height * 4, 0);
+        for (const size_t i : page.glyphs)
         {
-            for (int x = 0; x < gw; ++x)
+            const Glyph &g = glyphs[i];
+            for (int y = 0; y < g.raster.height; ++y)
             {
-                int dst = ((penY + y) * atlasSize + (penX + x)) * 4;
-                for (int i = 0; i < 4; ++i)
-                {
-                    atlas[dst + i] = (unsigned char)std::clamp(
-                        bmp(x, y)[i] * 255.0f, 0.0f, 255.0f);
-                }
+                std::copy_n(&g.raster.rgba[(size_t)y * g.raster.width * 4], (size_t)g.raster.width * 4,
+                            &atlas[((size_t)(g.y + y) * page.width + g.x) * 4]);
             }
-        }
-
-        FT_GlyphSlot slot = face->glyph;
-
-        Glyph g{};
-        g.advance = slot->advance.x / 64.0f;
-        g.bearingX = slot->metrics.horiBearingX / 64.0f;
-        g.bearingY = slot->metrics.horiBearingY / 64.0f;
-        g.w = gw;
-        g.h = gh;
-        g.x = penX;
-        g.y = penY;
 
-        glyphs[c] = g;
+            j["glyphs"][std::to_string((int)g.raster.codepoint)] = {
+                {"advance", g.raster.advance},
+                {"bearingX", g.raster.bearingX},
+                {"bearingY", g.raster.bearingY},
+                {"w", g.raster.width},
+                {"h", g.raster.height},
+                {"page", (int)p},
+                {"u0", float(g.x) / page.width},
+                {"v0", float(g.y) / page.height},
+                {"u1", float(g.x + g.raster.width) / page.width},
+                {"v1", float(g.y + g.raster.height) / page.height}};
+        }
 
-        penX += gw + rangePx;
-        rowH = std::max(rowH, gh);
+        SavePNG((outDir / file).string().c_str(), page.width, page.height, atlas);
+        j["pages"].push_back({{"file", file}, {"width", page.width}, {"height", page.height}});
+        std::cerr << file << ": " << page.width << "x" << page.height << ", " << page.glyphs.size() << " glyphs\n";
     }
 
-    std::filesystem::create_directories("assets/fonts");
-
-    SavePNG("assets/fonts/font.png", atlasSize, atlasSize, atlas);
-
-    json j;
-    j["atlasSize"] = atlasSize;
-
-    for (auto &[c, g] : glyphs)
+    // Kerning pairs from the font's 'kern' table, in pixels at glyphPxHeight.
+    // MsdfFont adds them to the pen between the two code points. Pairs are
+    // only looked up below U+3000: CJK is set on a fixed advance, and every
+    // pair of a large CJK charset would cost more than the rest of the bake.
+    j["kerning"] = json::array();
+    std::vector<const Glyph *> kerned;
+    if (FT_HAS_KERNING(face))
+    {
+        for (const Glyph &g : glyphs)
+        {
+            if (g.raster.codepoint < 0x3000)
+                kerned.push_back(&g);
+        }
+    }
+    for (const Glyph *left : kerned)
     {
-        j["glyphs"][std::to_string(c)] = {
-            {"advance", g.advance},
-            {"bearingX", g.bearingX},
-            {"bearingY", g.bearingY},
-            {"w", g.w},
-            {"h", g.h},
-            {"u0", float(g.x) / atlasSize},
-            {"v0", float(g.y) / atlasSize},
-            {"u1", float(g.x + g.w) / atlasSize},
-            {"v1", float(g.y + g.h) / atlasSize}};
+        for (const Glyph *right : kerned)
+        {
+            FT_Vector delta{};
+            if (FT_Get_Kerning(face, left->index, right->index, FT_KERNING_UNFITTED, &delta))
+                continue;
+            if (delta.x != 0)
+                j["kerning"].push_back({(int)left->raster.codepoint, (int)right->raster.codepoint, delta.x / 64.0f});
+        }
     }
+    std::cerr << "kerning pairs=" << j["kerning"].size() << "\n";
 
-    std::ofstream("assets/fonts/font.json") << j.dump(2);
-
-    msdfgen::destroyFont(font);
-    msdfgen::deinitializeFreetype(msft);
+    std::ofstream(outDir / (options.name + ".json")) << j.dump(2);
 
     FT_Done_Face(face);
     FT_Done_FreeType(ftLib);
 
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "done in " << seconds << " s\n";
     return 0;
 }
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <string_view>
+
+namespace util
+{
+    // Fixed-size stack buffer for text rebuilt every frame (counters, labels):
+    // printf-style formatting without heap allocation. Output longer than
+    // Capacity - 1 characters is truncated.
+    template <std::size_t Capacity = 128>
+    class FormatBuffer
+    {
+    public:
+        template <typename... Args>
+        std::string_view format(const char *fmt, Args... args) noexcept
+        {
+            const int n = std::snprintf(m_data, Capacity, fmt, args...);
+            m_size = n < 0 ? 0 : (static_cast<std::size_t>(n) < Capacity ? static_cast<std::size_t>(n) : Capacity - 1);
+            return view();
+        }
+
+        std::string_view view() const noexcept { return {m_data, m_size}; }
+
+    private:
+        char m_data[Capacity] = {};
+        std::size_t m_size = 0;
+    };
+}
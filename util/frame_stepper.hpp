@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+namespace util
+{
+    // Advances one sprite's frame cursor by `dt` using accumulator stepping:
+    // - No division
+    // - No modulo (wrap is a single compare)
+    // Only a sprite that fell more than one frame behind (e.g. its chunk just
+    // came back into view) pays for a floor/modulo catch-up.
+    // A non-positive (or NaN) seconds_per_frame holds the current frame.
+    inline uint32_t step_frame(float &accum, uint32_t cursor, float dt, float seconds_per_frame, uint32_t frame_count)
+    {
+        if (!(seconds_per_frame > 0.0f))
+        {
+            return cursor;
+        }
+
+        accum += dt;
+
+        // Fast path: step at most one frame per tick (good for stable frame times).
+        if (accum < seconds_per_frame)
+        {
+            return cursor;
+        }
+
+        accum -= seconds_per_frame;
+        uint32_t c = cursor + 1;
+
+        if (accum >= seconds_per_frame)
+        {
+            const float skipped = std::floor(accum / seconds_per_frame);
+            accum -= skipped * seconds_per_frame;
+            c += static_cast<uint32_t>(skipped);
+        }
+
+        if (c >= frame_count)
+        {
+            c = (c == frame_count || frame_count == 0) ? 0 : c % frame_count;
+        }
+        return c;
+    }
+}
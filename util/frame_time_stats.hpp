@@ -0,0 +1,49 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace util
+{
+    // Collects per-frame durations (seconds) for end-of-run percentiles.
+    class FrameTimeStats
+    {
+    public:
+        void reserve(std::size_t frames) { m_samples.reserve(frames); }
+
+        void add(double seconds)
+        {
+            m_samples.push_back(seconds);
+            m_total += seconds;
+        }
+
+        std::size_t count() const noexcept { return m_samples.size(); }
+        double total() const noexcept { return m_total; }
+
+        // Nearest-rank percentile, p in [0, 100]. Sorts a copy; call at the end of a run.
+        double percentile(double p) const
+        {
+            if (m_samples.empty())
+            {
+                return 0.0;
+            }
+
+            std::vector<double> sorted = m_samples;
+            const double rank = std::clamp(p, 0.0, 100.0) / 100.0 * static_cast<double>(sorted.size() - 1);
+            const auto nth = sorted.begin() + static_cast<std::ptrdiff_t>(rank + 0.5);
+            std::nth_element(sorted.begin(), nth, sorted.end());
+            return *nth;
+        }
+
+        void clear()
+        {
+            m_samples.clear();
+            m_total = 0.0;
+        }
+
+    private:
+        std::vector<double> m_samples;
+        double m_total = 0.0;
+    };
+}
@@ -0,0 +1,157 @@
+#include "glyph_rasterizer.hpp"
+
+#include <msdfgen.h>
+#include <msdfgen-ext.h>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include <algorithm>
+#include <cmath>
+
+namespace util
+{
+    GlyphRasterizer::~GlyphRasterizer()
+    {
+        close();
+    }
+
+    bool GlyphRasterizer::open(const std::string &font_path, int pixel_height, int range_px)
+    {
+        close();
+
+        if (FT_Init_FreeType(&m_library))
+        {
+            m_library = nullptr;
+            return false;
+        }
+
+        if (FT_New_Face(m_library, font_path.c_str(), 0, &m_face))
+        {
+            m_face = nullptr;
+            close();
+            return false;
+        }
+        FT_Set_Pixel_Sizes(m_face, 0, static_cast<FT_UInt>(pixel_height));
+        m_ascender = static_cast<float>(m_face->size->metrics.ascender) / 64.0f;
+
+        m_msdf_library = msdfgen::initializeFreetype();
+        m_font = m_msdf_library ? msdfgen::loadFont(m_msdf_library, font_path.c_str()) : nullptr;
+        if (!m_font)
+        {
+            close();
+            return false;
+        }
+
+        m_range_px = range_px;
+        if (!calibrate('M') && !calibrate('H') && !calibrate('A'))
+        {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void GlyphRasterizer::close()
+    {
+        if (m_font)
+        {
+            msdfgen::destroyFont(m_font);
+            m_font = nullptr;
+        }
+        if (m_msdf_library)
+        {
+            msdfgen::deinitializeFreetype(m_msdf_library);
+            m_msdf_library = nullptr;
+        }
+        if (m_face)
+        {
+            FT_Done_Face(m_face);
+            m_face = nullptr;
+        }
+        if (m_library)
+        {
+            FT_Done_FreeType(m_library);
+            m_library = nullptr;
+        }
+        m_px_per_unit = 0.0;
+    }
+
+    // Same scale atlas_generator uses: FreeType's pixel height of a capital
+    // over the msdfgen outline's height.
+    bool GlyphRasterizer::calibrate(char32_t codepoint)
+    {
+        if (FT_Load_Char(m_face, codepoint, FT_LOAD_NO_BITMAP))
+            return false;
+
+        msdfgen::Shape shape;
+        if (!msdfgen::loadGlyph(shape, m_font, codepoint))
+            return false;
+
+        const auto b = shape.getBounds();
+        const double msdf_h = b.t - b.b;
+        const double ft_h = m_face->glyph->metrics.height / 64.0;
+        if (!(msdf_h > 0.0) || !(ft_h > 0.0))
+            return false;
+
+        m_px_per_unit = ft_h / msdf_h;
+        return true;
+    }
+
+    bool GlyphRasterizer::rasterize(char32_t codepoint, RasterGlyph &out)
+    {
+        out = RasterGlyph{};
+        out.codepoint = codepoint;
+
+        if (!is_open())
+            return false;
+
+        const FT_UInt index = FT_Get_Char_Index(m_face, codepoint);
+        if (index == 0 || FT_Load_Glyph(m_face, index, FT_LOAD_NO_BITMAP))
+            return false;
+
+        msdfgen::Shape shape;
+        if (!msdfgen::loadGlyph(shape, m_font, codepoint))
+            return false;
+
+        msdfgen::edgeColoringSimple(shape, 3.0);
+        const msdfgen::Shape::Bounds b = shape.getBounds();
+
+        const FT_GlyphSlot slot = m_face->glyph;
+        out.found = true;
+        out.advance = static_cast<float>(slot->advance.x) / 64.0f;
+        out.bearingX = static_cast<float>(slot->metrics.horiBearingX) / 64.0f;
+        out.bearingY = static_cast<float>(slot->metrics.horiBearingY) / 64.0f;
+
+        // Blank glyphs (space) have inverted bounds; keep just the range border.
+        const double w_px = std::max(0.0, (b.r - b.l) * m_px_per_unit);
+        const double h_px = std::max(0.0, (b.t - b.b) * m_px_per_unit);
+        out.width = static_cast<int>(std::ceil(w_px)) + m_range_px * 2;
+        out.height = static_cast<int>(std::ceil(h_px)) + m_range_px * 2;
+
+        msdfgen::Bitmap<float, 4> bmp(out.width, out.height);
+
+        // Transform: shapeCoord * scale + translate = pixelCoord
+        const double left = w_px > 0.0 ? b.l : 0.0;
+        const double bottom = h_px > 0.0 ? b.b : 0.0;
+        const msdfgen::Vector2 scale(m_px_per_unit, m_px_per_unit);
+        const msdfgen::Vector2 translate(m_range_px - left * m_px_per_unit,
+                                         m_range_px - bottom * m_px_per_unit);
+        msdfgen::generateMTSDF(bmp, shape, m_range_px, scale, translate);
+
+        out.rgba.resize(static_cast<size_t>(out.width) * static_cast<size_t>(out.height) * 4);
+        unsigned char *dst = out.rgba.data();
+        for (int y = 0; y < out.height; ++y)
+        {
+            for (int x = 0; x < out.width; ++x)
+            {
+                const float *texel = bmp(x, y);
+                for (int i = 0; i < 4; ++i)
+                {
+                    *dst++ = static_cast<unsigned char>(std::clamp(texel[i] * 255.0f, 0.0f, 255.0f));
+                }
+            }
+        }
+        return true;
+    }
+}
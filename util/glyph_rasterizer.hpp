@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+struct FT_LibraryRec_;
+struct FT_FaceRec_;
+
+namespace msdfgen
+{
+    class FreetypeHandle;
+    class FontHandle;
+}
+
+namespace util
+{
+    // One glyph rendered as an MTSDF bitmap, with MsdfFont's metrics
+    // (pixels at the rasterizer's size).
+    struct RasterGlyph
+    {
+        char32_t codepoint = 0;
+        bool found = false; // false: the font has no glyph for codepoint
+
+        float advance = 0.0f;
+        float bearingX = 0.0f;
+        float bearingY = 0.0f;
+
+        // RGBA8, width * height * 4 bytes; row 0 is the bottom of the glyph,
+        // as atlas_generator writes it.
+        int width = 0;
+        int height = 0;
+        std::vector<unsigned char> rgba;
+    };
+
+    // FreeType metrics plus msdfgen outlines for one font file, rendering
+    // glyphs the way atlas_generator does. Not thread safe: use one instance
+    // per thread (renderer::GlyphCache hands its instance to its worker).
+    class GlyphRasterizer
+    {
+    public:
+        GlyphRasterizer() = default;
+        ~GlyphRasterizer();
+
+        GlyphRasterizer(const GlyphRasterizer &) = delete;
+        GlyphRasterizer &operator=(const GlyphRasterizer &) = delete;
+
+        // pixel_height: roughly the EM height; range_px: distance field range.
+        bool open(const std::string &font_path, int pixel_height, int range_px);
+        void close();
+
+        bool is_open() const noexcept { return m_font != nullptr; }
+
+        // Fills `out` and returns true if the font covers `codepoint`.
+        bool rasterize(char32_t codepoint, RasterGlyph &out);
+
+        // Baseline to top of the tallest glyphs, in pixels.
+        float ascender() const noexcept { return m_ascender; }
+
+    private:
+        bool calibrate(char32_t codepoint);
+
+        FT_LibraryRec_ *m_library = nullptr;
+        FT_FaceRec_ *m_face = nullptr;
+        msdfgen::FreetypeHandle *m_msdf_library = nullptr;
+        msdfgen::FontHandle *m_font = nullptr;
+
+        // msdfgen shape units to pixels, measured against FreeType's metrics.
+        double m_px_per_unit = 0.0;
+        int m_range_px = 0;
+        float m_ascender = 0.0f;
+    };
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace util
+{
+    // Kerning adjustments keyed by (left, right) code point pair.
+    // Open addressing with linear probing over a power-of-two table kept at
+    // most half full: a lookup is one multiply-shift and, almost always, one
+    // or two adjacent 16-byte slots. Built once at font load.
+    class KerningTable
+    {
+    public:
+        void clear()
+        {
+            m_slots.clear();
+            m_count = 0;
+            m_shift = 64;
+        }
+
+        bool empty() const noexcept { return m_count == 0; }
+        size_t size() const noexcept { return m_count; }
+
+        void set(char32_t left, char32_t right, float amount)
+        {
+            if ((m_count + 1) * 2 > m_slots.size())
+            {
+                rehash(m_slots.empty() ? 64 : m_slots.size() * 2);
+            }
+            if (insert(key(left, right), amount))
+            {
+                ++m_count;
+            }
+        }
+
+        // 0 when the pair has no entry.
+        float get(char32_t left, char32_t right) const noexcept
+        {
+            if (m_count == 0)
+                return 0.0f;
+
+            const uint64_t k = key(left, right);
+            const size_t mask = m_slots.size() - 1;
+            for (size_t i = slot_for(k);; i = (i + 1) & mask)
+            {
+                const Slot &s = m_slots[i];
+                if (s.key == k)
+                    return s.amount;
+                if (s.key == EmptyKey)
+                    return 0.0f;
+            }
+        }
+
+    private:
+        struct Slot
+        {
+            uint64_t key;
+            float amount;
+        };
+
+        // Code points stop at U+10FFFF, so an all-ones key never occurs.
+        static constexpr uint64_t EmptyKey = ~uint64_t(0);
+
+        static uint64_t key(char32_t left, char32_t right) noexcept
+        {
+            return (uint64_t(left) << 32) | uint64_t(right);
+        }
+
+        size_t slot_for(uint64_t k) const noexcept
+        {
+            // Fibonacci hashing: the high bits of the product pick the slot.
+            return static_cast<size_t>((k * 0x9E3779B97F4A7C15ull) >> m_shift);
+        }
+
+        // False when `k` was already present (its amount is overwritten).
+        bool insert(uint64_t k, float amount)
+        {
+            const size_t mask = m_slots.size() - 1;
+            for (size_t i = slot_for(k);; i = (i + 1) & mask)
+            {
+                Slot &s = m_slots[i];
+                if (s.key == k)
+                {
+                    s.amount = amount;
+                    return false;
+                }
+                if (s.key == EmptyKey)
+                {
+                    s = {k, amount};
+                    return true;
+                }
+            }
+        }
+
+        void rehash(size_t capacity)
+        {
+            std::vector<Slot> old = std::move(m_slots);
+            m_slots.assign(capacity, Slot{EmptyKey, 0.0f});
+
+            m_shift = 64;
+            for (size_t c = capacity; c > 1; c >>= 1)
+            {
+                --m_shift;
+            }
+
+            for (const Slot &s : old)
+            {
+                if (s.key != EmptyKey)
+                {
+                    insert(s.key, s.amount);
+                }
+            }
+        }
+
+        std::vector<Slot> m_slots;
+        size_t m_count = 0;
+        unsigned int m_shift = 64;
+    };
+}
@@ -1,12 +1,20 @@
 #pragma once
 
+#include "renderer/sprite_renderer.hpp"
+#include "util/kerning_table.hpp"
+#include "util/profiler.hpp"
 #include "util/sprite_sheet.hpp"
+#include "util/utf8.hpp"
+#include <glm/vec2.hpp>
 #include <glm/vec4.hpp>
 #include <nlohmann/json.hpp>
 
+#include <array>
+#include <cstdint>
 #include <fstream>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <vector>
 #include <algorithm>
 
 namespace util
@@ -19,13 +27,18 @@ namespace util
         float w = 0.0f; // pixel size in atlas
         float h = 0.0f;
         glm::vec4 uv{0, 0, 1, 1}; // u0,v0,u1,v1
+        unsigned int frame = 0;   // index into the atlas sheet's UV table
     };
 
     class MsdfFont
     {
     public:
+        MsdfFont() { m_direct.fill(NoGlyph); }
+
         bool load(const std::string &json_path, const std::string &png_path)
         {
+            PROFILE_SCOPE("MsdfFont::load");
+
             using json = nlohmann::json;
 
             std::ifstream f(json_path);
@@ -41,18 +54,34 @@ namespace util
 
             // Load the atlas as a 1x1 "sheet" so SpriteRenderer can use its texture.
             // This passes SpriteSheet's validation requirements. :contentReference[oaicite:1]{index=1}
-            if (!m_sheet.load_from_file(png_path, m_atlas_size, m_atlas_size, false))
+            // Distance fields, not colours: no color key or premultiplication.
+            if (!m_sheet.load_from_file(png_path, 1, 1, false, TextureAlpha::Straight))
                 return false;
 
             m_glyphs.clear();
+            m_direct.fill(NoGlyph);
+            m_sparse.clear();
+            m_kerning.clear();
+            m_fallback = NoGlyph;
             m_line_height = 0.0f;
 
+            // Glyph rects become the sheet's UV table; each glyph's frame is its slot.
+            std::vector<glm::vec4> uv_rects;
+
             const auto &glyphs = j["glyphs"];
             for (auto it = glyphs.begin(); it != glyphs.end(); ++it)
             {
                 const int codepoint = std::stoi(it.key());
+                if (codepoint < 0 || m_glyphs.size() >= NoGlyph)
+                    continue;
                 const auto &g = it.value();
 
+                // Single-page atlases only: glyphs atlas_generator spilled to
+                // further pages are left out (renderer::GlyphCache covers
+                // large charsets).
+                if (g.value("page", 0) != 0)
+                    continue;
+
                 MsdfGlyph out{};
                 out.advance = g.value("advance", 0.0f);
                 out.bearingX = g.value("bearingX", 0.0f);
@@ -67,9 +96,39 @@ namespace util
 
                 // NOTE: v0/v1 are inverted.
                 out.uv = {u0, v1, u1, v0};
+                out.frame = static_cast<unsigned int>(uv_rects.size());
+                uv_rects.push_back(out.uv);
 
                 m_line_height = std::max(m_line_height, out.bearingY);
-                m_glyphs.emplace(codepoint, out);
+
+                const auto index = static_cast<uint16_t>(m_glyphs.size());
+                m_glyphs.push_back(out);
+                if (codepoint < static_cast<int>(m_direct.size()))
+                    m_direct[static_cast<size_t>(codepoint)] = index;
+                else
+                    m_sparse.push_back({static_cast<char32_t>(codepoint), index});
+            }
+
+            std::sort(m_sparse.begin(), m_sparse.end(),
+                      [](const SparseGlyph &a, const SparseGlyph &b) { return a.codepoint < b.codepoint; });
+
+            m_sheet.set_uv_rects(uv_rects);
+
+            // [[left, right, pixels], ...] at the atlas' pixel size; optional.
+            if (const auto kerning = j.find("kerning"); kerning != j.end())
+            {
+                for (const auto &pair : *kerning)
+                {
+                    if (pair.size() == 3)
+                        m_kerning.set(pair[0].get<uint32_t>(), pair[1].get<uint32_t>(), pair[2].get<float>());
+                }
+            }
+
+            // Missing glyphs draw as U+FFFD, or '?' if the atlas lacks it.
+            for (const int cp : {static_cast<int>(ReplacementChar), int('?')})
+            {
+                if (const MsdfGlyph *g = glyph(cp); g && m_fallback == NoGlyph)
+                    m_fallback = static_cast<uint16_t>(g - m_glyphs.data());
             }
 
             // Fallback if bearingY was missing/0 for some reason
@@ -82,50 +141,95 @@ namespace util
         const SpriteSheet &sheet() const noexcept { return m_sheet; }
         SpriteSheet &sheet() noexcept { return m_sheet; }
 
+        // Latin-1 is one indexed load; anything above is a binary search
+        // over the (few) remaining glyphs.
         const MsdfGlyph *glyph(int codepoint) const
         {
-            auto it = m_glyphs.find(codepoint);
-            if (it == m_glyphs.end())
+            if (codepoint < 0)
                 return nullptr;
-            return &it->second;
+
+            if (codepoint < static_cast<int>(m_direct.size()))
+            {
+                const uint16_t index = m_direct[static_cast<size_t>(codepoint)];
+                return index == NoGlyph ? nullptr : &m_glyphs[index];
+            }
+
+            const auto cp = static_cast<char32_t>(codepoint);
+            const auto it = std::lower_bound(m_sparse.begin(), m_sparse.end(), cp,
+                                             [](const SparseGlyph &g, char32_t c) { return g.codepoint < c; });
+            if (it == m_sparse.end() || it->codepoint != cp)
+                return nullptr;
+            return &m_glyphs[it->index];
+        }
+
+        // Horizontal adjustment in atlas pixels between two adjacent code points.
+        float kerning(char32_t left, char32_t right) const noexcept
+        {
+            return m_kerning.get(left, right);
         }
 
         float line_height() const noexcept { return m_line_height; }
 
+        // Inside a Font batch; glyphs are packed for, and drawn from, sheet().
         void render_text(
             renderer::SpriteRenderer &renderer,
-            util::SpriteSheet *sheet,
-            const std::string &text,
+            std::string_view text,
             float x,
             float y,
             float scale = 1.0f)
         {
-            float cursor_x = x;
+            m_layout.clear();
+            layout(text, scale, m_layout);
+            renderer.submit_glyphs(&m_sheet, m_layout, {x, y});
+        }
+
+        // Appends the glyph instances of UTF-8 `text` to `out`, relative to
+        // the text's top-left corner (see renderer::TextRunCache).
+        void layout(std::string_view text, float scale, std::vector<renderer::GpuSpriteInstance> &out) const
+        {
+            float cursor_x = 0.0f;
 
             // Treat y as top-left; convert to a baseline using the font's measured line height.
-            const float baseline_y = y + line_height() * scale;
+            const float baseline_y = line_height() * scale;
+            const bool kerned = !m_kerning.empty();
 
-            for (unsigned char c : text)
+            // Previous drawn code point, for kerning; 0 breaks the pair.
+            char32_t prev = 0;
+
+            for (size_t i = 0; i < text.size();)
             {
-                // Basic ASCII set your atlas_generator emits (32..126). :contentReference[oaicite:4]{index=4}
-                if (c < 32 || c > 126)
+                const char32_t cp = next_code_point(text, i);
+
+                // Control characters (tab, newline, ...) stay a half-line gap.
+                if (cp < 32 || (cp >= 0x7F && cp < 0xA0))
                 {
                     cursor_x += line_height() * 0.5f * scale;
+                    prev = 0;
                     continue;
                 }
 
-                const util::MsdfGlyph *g = glyph((int)c);
+                const util::MsdfGlyph *g = glyph(static_cast<int>(cp));
+                if (!g && m_fallback != NoGlyph)
+                    g = &m_glyphs[m_fallback];
                 if (!g)
+                {
+                    cursor_x += line_height() * 0.5f * scale;
+                    prev = 0;
                     continue;
+                }
+
+                if (kerned && prev)
+                    cursor_x += m_kerning.get(prev, cp) * scale;
+                prev = cp;
 
                 // Position quad using bearings (baseline-aligned)
                 const float gx = cursor_x + g->bearingX * scale;
                 const float gy = baseline_y - g->bearingY * scale;
 
-                renderer.submit(sheet, renderer::SpriteInstance{
+                out.push_back(renderer::pack_instance(m_sheet, renderer::SpriteInstance{
                     .pos = {gx, gy},
                     .size = {g->w * scale, g->h * scale},
-                    .uv = g->uv});
+                    .frame_index = g->frame}));
 
                 cursor_x += g->advance * scale;
             }
@@ -135,6 +239,24 @@ namespace util
         SpriteSheet m_sheet{};
         int m_atlas_size = 0;
         float m_line_height = 0.0f;
-        std::unordered_map<int, MsdfGlyph> m_glyphs{};
+
+        struct SparseGlyph
+        {
+            char32_t codepoint;
+            uint16_t index;
+        };
+
+        static constexpr uint16_t NoGlyph = 0xFFFF;
+
+        // Glyphs in load order; m_direct covers U+0000..U+00FF, m_sparse
+        // (sorted by code point) the rest.
+        std::vector<MsdfGlyph> m_glyphs{};
+        std::array<uint16_t, 256> m_direct{};
+        std::vector<SparseGlyph> m_sparse{};
+        uint16_t m_fallback = NoGlyph;
+        KerningTable m_kerning{};
+
+        // render_text scratch; keeps its capacity.
+        std::vector<renderer::GpuSpriteInstance> m_layout;
     };
 }
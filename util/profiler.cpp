@@ -0,0 +1,175 @@
+#include "profiler.hpp"
+
+#ifdef GAME_PROFILER
+
+#include <array>
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace util::profiler
+{
+    namespace
+    {
+        // 768 KiB per recording thread.
+        constexpr std::uint64_t RingEvents = 1u << 15;
+
+        // Single producer (the owning thread), single consumer (the dump,
+        // under the registry mutex). The owner publishes `written` with
+        // release; the dump publishes `read` once it no longer needs the
+        // events below it, and the owner only reuses slots below `read`.
+        struct ThreadBuffer
+        {
+            std::uint32_t thread_id = 0;
+            std::array<Event, RingEvents> events;
+            std::atomic<std::uint64_t> written{0};
+            std::atomic<std::uint64_t> read{0};
+            std::atomic<std::uint64_t> dropped{0};
+        };
+
+        // Buffers are registered once per thread and live until exit, so a
+        // dump can walk a thread's events after that thread has finished.
+        struct Registry
+        {
+            std::mutex mutex;
+            std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+        };
+
+        // Trace timestamps are relative to program start.
+        const std::uint64_t epoch_ns = now_ns();
+
+        Registry &registry()
+        {
+            static Registry instance;
+            return instance;
+        }
+
+        // Null if registration failed; that thread then records nothing.
+        ThreadBuffer *thread_buffer() noexcept
+        {
+            thread_local ThreadBuffer *buffer = []() noexcept -> ThreadBuffer *
+            {
+                try
+                {
+                    Registry &r = registry();
+                    std::lock_guard lock(r.mutex);
+                    auto owned = std::make_unique<ThreadBuffer>();
+                    owned->thread_id = static_cast<std::uint32_t>(r.buffers.size());
+                    r.buffers.push_back(std::move(owned));
+                    return r.buffers.back().get();
+                }
+                catch (...)
+                {
+                    return nullptr;
+                }
+            }();
+            return buffer;
+        }
+
+        void write_escaped(std::FILE *file, const char *text)
+        {
+            for (const char *c = text; *c; ++c)
+            {
+                if (*c == '"' || *c == '\\')
+                {
+                    std::fputc('\\', file);
+                }
+                std::fputc(*c, file);
+            }
+        }
+    }
+
+    void record(const char *name, std::uint64_t start_ns, std::uint64_t end_ns) noexcept
+    {
+        ThreadBuffer *buffer = thread_buffer();
+        if (!buffer)
+        {
+            return;
+        }
+
+        const std::uint64_t written = buffer->written.load(std::memory_order_relaxed);
+        if (written - buffer->read.load(std::memory_order_acquire) == RingEvents)
+        {
+            buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        buffer->events[written % RingEvents] = Event{name, start_ns, end_ns};
+        buffer->written.store(written + 1, std::memory_order_release);
+    }
+
+    bool write_chrome_trace(const std::string &path)
+    {
+        std::FILE *file = std::fopen(path.c_str(), "wb");
+        if (!file)
+        {
+            return false;
+        }
+
+        Registry &r = registry();
+        std::lock_guard lock(r.mutex);
+
+        std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+
+        // End of what this dump wrote and drops it reported, per buffer;
+        // released only once the file is complete.
+        std::vector<std::uint64_t> ends;
+        std::vector<std::uint64_t> drops;
+        ends.reserve(r.buffers.size());
+        drops.reserve(r.buffers.size());
+        const double dump_us = static_cast<double>(now_ns() - epoch_ns) * 1e-3;
+
+        bool first = true;
+        for (const auto &buffer : r.buffers)
+        {
+            const std::uint64_t begin = buffer->read.load(std::memory_order_relaxed);
+            const std::uint64_t end = buffer->written.load(std::memory_order_acquire);
+            const std::uint64_t dropped = buffer->dropped.load(std::memory_order_relaxed);
+            ends.push_back(end);
+            drops.push_back(dropped);
+
+            if (dropped > 0)
+            {
+                // Thread-scoped instant event at the time of the dump.
+                std::fputs(first ? "" : ",\n", file);
+                std::fprintf(file,
+                             "{\"name\":\"profiler: %" PRIu64 " zones dropped (ring full)\",\"ph\":\"i\",\"s\":\"t\","
+                             "\"pid\":1,\"tid\":%" PRIu32 ",\"ts\":%.3f}",
+                             dropped, buffer->thread_id, dump_us);
+                first = false;
+            }
+
+            for (std::uint64_t i = begin; i < end; ++i)
+            {
+                const Event &e = buffer->events[i % RingEvents];
+
+                // Complete ("X") events; timestamps in microseconds.
+                std::fputs(first ? "" : ",\n", file);
+                std::fputs("{\"name\":\"", file);
+                write_escaped(file, e.name);
+                std::fprintf(file, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%" PRIu32 ",\"ts\":%.3f,\"dur\":%.3f}",
+                             buffer->thread_id,
+                             static_cast<double>(e.start_ns - epoch_ns) * 1e-3,
+                             static_cast<double>(e.end_ns - e.start_ns) * 1e-3);
+                first = false;
+            }
+        }
+
+        std::fputs("\n]}\n", file);
+        if (std::fclose(file) != 0)
+        {
+            return false;
+        }
+
+        for (std::size_t b = 0; b < r.buffers.size(); ++b)
+        {
+            r.buffers[b]->read.store(ends[b], std::memory_order_release);
+            r.buffers[b]->dropped.fetch_sub(drops[b], std::memory_order_relaxed);
+        }
+        return true;
+    }
+}
+
+#endif
@@ -0,0 +1,80 @@
+#pragma once
+
+// Scoped CPU zones exported as Chrome trace event JSON (chrome://tracing,
+// ui.perfetto.dev).
+//
+//   PROFILE_SCOPE("name");     // zone until the end of the enclosing block
+//   PROFILE_FUNCTION();        // zone named after the function
+//   PROFILE_WRITE_TRACE(path); // dump the zones recorded since the last dump
+//                              // (false if disabled or the file cannot be
+//                              // written; the zones are then kept)
+//
+// Only built with GAME_PROFILER defined (CMake option GAME_PROFILER); otherwise
+// the macros expand to nothing and no profiler code is compiled in.
+//
+// Each thread appends to its own fixed ring of events, allocated on its first
+// zone: recording a zone is two clock reads and a store, with no locks or
+// allocation. A dump frees the ring; zones recorded while it is full are
+// dropped and counted in the next dump. Names must be string literals (only
+// the pointer is kept).
+
+#ifdef GAME_PROFILER
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace util::profiler
+{
+    struct Event
+    {
+        const char *name;
+        std::uint64_t start_ns;
+        std::uint64_t end_ns;
+    };
+
+    inline std::uint64_t now_ns() noexcept
+    {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch())
+                .count());
+    }
+
+    // Appends to the calling thread's ring, or drops the zone if it is full.
+    void record(const char *name, std::uint64_t start_ns, std::uint64_t end_ns) noexcept;
+
+    // Writes and releases the recorded zones. Safe while other threads keep
+    // recording; zones they publish during the write go to the next dump.
+    bool write_chrome_trace(const std::string &path);
+
+    class Zone
+    {
+    public:
+        explicit Zone(const char *name) noexcept : m_name(name), m_start(now_ns()) {}
+        ~Zone() { record(m_name, m_start, now_ns()); }
+
+        Zone(const Zone &) = delete;
+        Zone &operator=(const Zone &) = delete;
+
+    private:
+        const char *m_name;
+        std::uint64_t m_start;
+    };
+}
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#define PROFILE_SCOPE(name) ::util::profiler::Zone PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+#define PROFILE_WRITE_TRACE(path) ::util::profiler::write_chrome_trace(path)
+
+#else
+
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_FUNCTION() ((void)0)
+#define PROFILE_WRITE_TRACE(path) ((void)(path), false)
+
+#endif
@@ -0,0 +1,212 @@
+#include "sheet_array.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <utility>
+
+#include "sprite_sheet.hpp"
+#include "profiler.hpp"
+
+namespace util
+{
+    namespace
+    {
+        int next_pow2(int v)
+        {
+            int p = 1;
+            while (p < v)
+            {
+                p <<= 1;
+            }
+            return p;
+        }
+
+        int overlay_count(const SpriteSheet &sheet)
+        {
+            return 1 + (sheet.has_shadow() ? 1 : 0) + (sheet.has_mask() ? 1 : 0);
+        }
+    }
+
+    bool SheetArray::create(int cell_width, int cell_height, int layers)
+    {
+        m_entries.assign(static_cast<size_t>(layers), glm::vec4{1.0f, 1.0f, -1.0f, -1.0f});
+        m_trims.assign(static_cast<size_t>(layers), glm::vec4{0.0f, 0.0f, 1.0f, 1.0f});
+        m_next_layer = 0;
+        m_has_shadow = false;
+        m_has_mask = false;
+        m_alpha_class = AlphaClass::Opaque;
+        return m_texture.create(cell_width, cell_height, layers);
+    }
+
+    int SheetArray::add_cells(const Texture &texture, int cols, int rows)
+    {
+        const int first = m_next_layer;
+        if (cols <= 0 || rows <= 0 || m_next_layer + cols * rows > m_texture.layers())
+        {
+            return first;
+        }
+
+        const int cell_w = std::min(texture.width() / cols, m_texture.width());
+        const int cell_h = std::min(texture.height() / rows, m_texture.height());
+
+        const auto pixels = texture.read_pixels();
+        const size_t src_stride = static_cast<size_t>(texture.width()) * 4;
+        const size_t dst_stride = static_cast<size_t>(m_texture.width()) * 4;
+
+        std::vector<unsigned char> layer(dst_stride * static_cast<size_t>(m_texture.height()), 0);
+
+        for (int row = 0; row < rows; ++row)
+        {
+            for (int col = 0; col < cols; ++col)
+            {
+                std::fill(layer.begin(), layer.end(), 0);
+
+                for (int y = 0; y < cell_h; ++y)
+                {
+                    const size_t src = (static_cast<size_t>(row * cell_h + y) * src_stride) + static_cast<size_t>(col * cell_w) * 4;
+                    std::memcpy(layer.data() + static_cast<size_t>(y) * dst_stride, pixels.data() + src, static_cast<size_t>(cell_w) * 4);
+                }
+
+                m_texture.upload_layer(m_next_layer, layer.data());
+
+                m_entries[static_cast<size_t>(m_next_layer)] = {
+                    static_cast<float>(cell_w) / static_cast<float>(m_texture.width()),
+                    static_cast<float>(cell_h) / static_cast<float>(m_texture.height()),
+                    -1.0f,
+                    -1.0f};
+
+                ++m_next_layer;
+            }
+        }
+
+        return first;
+    }
+
+    void SheetArray::link_overlays(int base, int count, int shadow, int mask)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            auto &e = m_entries[static_cast<size_t>(base + i)];
+            e.z = (shadow >= 0) ? static_cast<float>(shadow + i) : -1.0f;
+            e.w = (mask >= 0) ? static_cast<float>(mask + i) : -1.0f;
+        }
+
+        m_has_shadow = m_has_shadow || shadow >= 0;
+        m_has_mask = m_has_mask || mask >= 0;
+    }
+
+    void SheetArray::set_trims(int base, const std::vector<glm::vec4> &trims)
+    {
+        const size_t first = static_cast<size_t>(base);
+        const size_t count = std::min(trims.size(), m_trims.size() - std::min(first, m_trims.size()));
+        std::copy_n(trims.begin(), count, m_trims.begin() + static_cast<std::ptrdiff_t>(first));
+    }
+
+    void SheetArray::finalize()
+    {
+        m_layer_table.upload(m_entries);
+        m_trim_table.upload(m_trims);
+        m_texture.generate_mipmaps();
+    }
+
+    void SheetArray::release()
+    {
+        m_texture.release();
+        m_layer_table.release();
+        m_trim_table.release();
+        m_entries.clear();
+        m_trims.clear();
+        m_next_layer = 0;
+    }
+
+    std::vector<std::unique_ptr<SheetArray>> build_sheet_arrays(const std::vector<SpriteSheet *> &sheets)
+    {
+        PROFILE_SCOPE("build_sheet_arrays");
+
+        std::vector<std::unique_ptr<SheetArray>> arrays;
+
+        GLint max_layers = 0;
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers);
+
+        // Size class -> sheets (std::map keeps the build order deterministic).
+        std::map<std::pair<int, int>, std::vector<SpriteSheet *>> classes;
+
+        for (SpriteSheet *sheet : sheets)
+        {
+            // Sheets that can't fit in one array keep drawing from their own texture.
+            if (!sheet || sheet->sprite_count() <= 0 || sheet->sprite_count() * overlay_count(*sheet) > max_layers)
+            {
+                continue;
+            }
+
+            const int cols = sheet->columns();
+            const int rows = sheet->rows();
+
+            int w = sheet->base_sprite().sprite_width;
+            int h = sheet->base_sprite().sprite_height;
+
+            // Overlays share the base grid but may be authored at another resolution.
+            for (const Sprite *overlay : {&sheet->shadow_sprite(), &sheet->mask_sprite()})
+            {
+                if (overlay->texture.is_valid())
+                {
+                    w = std::max(w, overlay->texture.width() / cols);
+                    h = std::max(h, overlay->texture.height() / rows);
+                }
+            }
+
+            classes[{next_pow2(w), next_pow2(h)}].push_back(sheet);
+        }
+
+        for (auto &[size, members] : classes)
+        {
+            size_t begin = 0;
+            while (begin < members.size())
+            {
+                // Greedily take sheets until the layer limit is hit.
+                int layers = 0;
+                size_t end = begin;
+                while (end < members.size())
+                {
+                    const int need = members[end]->sprite_count() * overlay_count(*members[end]);
+                    if (layers > 0 && layers + need > max_layers)
+                    {
+                        break;
+                    }
+                    layers += need;
+                    ++end;
+                }
+
+                auto array = std::make_unique<SheetArray>();
+                if (!array->create(size.first, size.second, layers))
+                {
+                    begin = end;
+                    continue;
+                }
+
+                for (size_t i = begin; i < end; ++i)
+                {
+                    SpriteSheet &sheet = *members[i];
+                    const int cols = sheet.columns();
+                    const int rows = sheet.rows();
+
+                    const int base = array->add_cells(sheet.base_sprite().texture, cols, rows);
+                    const int shadow = sheet.has_shadow() ? array->add_cells(sheet.shadow_sprite().texture, cols, rows) : -1;
+                    const int mask = sheet.has_mask() ? array->add_cells(sheet.mask_sprite().texture, cols, rows) : -1;
+
+                    array->link_overlays(base, sheet.sprite_count(), shadow, mask);
+                    array->set_trims(base, sheet.frame_trims());
+                    sheet.set_array_slot(array.get(), base);
+                    array->merge_alpha_class(sheet.alpha_class());
+                }
+
+                array->finalize();
+                arrays.push_back(std::move(array));
+                begin = end;
+            }
+        }
+
+        return arrays;
+    }
+}
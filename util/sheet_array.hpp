@@ -0,0 +1,87 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <glm/vec4.hpp>
+
+#include "alpha_class.hpp"
+#include "texture.hpp"
+#include "texture_array.hpp"
+#include "uv_table.hpp"
+
+namespace util
+{
+    class SpriteSheet;
+
+    // One size class of sprite cells packed into a GL_TEXTURE_2D_ARRAY,
+    // one cell per layer. Every sheet packed here draws with the same texture
+    // binding, so a whole size class is a single instanced draw.
+    //
+    // The layer table holds one entry per layer:
+    //   (u1, v1, shadow_layer, mask_layer)
+    // where (u1, v1) is the used extent of the layer (cells smaller than the
+    // class are stored top-left) and the overlay layers are -1 when absent.
+    // The trim table holds each layer's trim rect (see SpriteSheet::frame_trims).
+    class SheetArray
+    {
+    public:
+        SheetArray() = default;
+
+        SheetArray(const SheetArray &) = delete;
+        SheetArray &operator=(const SheetArray &) = delete;
+
+        bool create(int cell_width, int cell_height, int layers);
+
+        // Copies every cell of `texture` (cols x rows grid) into consecutive
+        // layers; returns the first layer used.
+        int add_cells(const Texture &texture, int cols, int rows);
+
+        // Links base layers [base, base+count) to their overlay layers.
+        void link_overlays(int base, int count, int shadow, int mask);
+
+        // Trim rects of base layers [base, base + trims.size()).
+        void set_trims(int base, const std::vector<glm::vec4> &trims);
+
+        // Uploads the layer tables and builds the mip chain; call after the
+        // last add_cells.
+        void finalize();
+
+        const TextureArray &texture() const noexcept { return m_texture; }
+        const UvTable &layer_table() const noexcept { return m_layer_table; }
+        const UvTable &trim_table() const noexcept { return m_trim_table; }
+
+        bool has_shadow() const noexcept { return m_has_shadow; }
+        bool has_mask() const noexcept { return m_has_mask; }
+
+        // Worst alpha class of the packed sheets; Translucent once overlays are
+        // linked, since overlay passes blend over what is already drawn.
+        AlphaClass alpha_class() const noexcept
+        {
+            return (m_has_shadow || m_has_mask) ? AlphaClass::Translucent : m_alpha_class;
+        }
+        void merge_alpha_class(AlphaClass c) noexcept { m_alpha_class = worst(m_alpha_class, c); }
+
+        int cell_width() const noexcept { return m_texture.width(); }
+        int cell_height() const noexcept { return m_texture.height(); }
+
+        void release();
+
+    private:
+        TextureArray m_texture;
+        UvTable m_layer_table;
+        UvTable m_trim_table;
+        std::vector<glm::vec4> m_entries;
+        std::vector<glm::vec4> m_trims;
+
+        int m_next_layer{};
+        bool m_has_shadow = false;
+        bool m_has_mask = false;
+        AlphaClass m_alpha_class = AlphaClass::Opaque;
+    };
+
+    // Groups sheets into power-of-two cell size classes and packs each class
+    // into one or more SheetArrays (split when GL_MAX_ARRAY_TEXTURE_LAYERS is
+    // reached). Each sheet is told which array and first layer it landed in.
+    std::vector<std::unique_ptr<SheetArray>> build_sheet_arrays(const std::vector<SpriteSheet *> &sheets);
+}
@@ -0,0 +1,173 @@
+#include "spatial_grid.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <glm/common.hpp>
+
+#include "profiler.hpp"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define SPATIAL_GRID_SSE 1
+#endif
+
+namespace util
+{
+    namespace
+    {
+        constexpr float Inf = std::numeric_limits<float>::infinity();
+        constexpr uint32_t SimdPad = 3;
+    }
+
+    void SpatialGrid::build(std::span<const Aabb> bounds)
+    {
+        PROFILE_SCOPE("SpatialGrid::build");
+
+        m_cols = 0;
+        m_rows = 0;
+        m_max_extent = glm::vec2(0.0f);
+        m_offsets.assign(1, 0);
+        m_items.clear();
+        m_min_x.assign(SimdPad, Inf);
+        m_min_y.assign(SimdPad, Inf);
+        m_max_x.assign(SimdPad, -Inf);
+        m_max_y.assign(SimdPad, -Inf);
+
+        if (bounds.empty())
+        {
+            return;
+        }
+
+        glm::vec2 lo(Inf);
+        glm::vec2 hi(-Inf);
+        for (const Aabb &b : bounds)
+        {
+            lo = glm::min(lo, b.min);
+            hi = glm::max(hi, b.min);
+            m_max_extent = glm::max(m_max_extent, b.max - b.min);
+        }
+
+        m_origin = glm::vec2(std::floor(lo.x / m_chunk_size), std::floor(lo.y / m_chunk_size)) * m_chunk_size;
+        m_cols = static_cast<int>((hi.x - m_origin.x) / m_chunk_size) + 1;
+        m_rows = static_cast<int>((hi.y - m_origin.y) / m_chunk_size) + 1;
+
+        const uint32_t count = chunk_count();
+        const auto chunk_of = [this](const Aabb &b)
+        {
+            const int cx = std::min(m_cols - 1, static_cast<int>((b.min.x - m_origin.x) / m_chunk_size));
+            const int cy = std::min(m_rows - 1, static_cast<int>((b.min.y - m_origin.y) / m_chunk_size));
+            return static_cast<uint32_t>(cy * m_cols + cx);
+        };
+
+        // Counting sort: sizes, prefix sums, then scatter in item order.
+        m_offsets.assign(count + 1, 0);
+        for (const Aabb &b : bounds)
+        {
+            ++m_offsets[chunk_of(b) + 1];
+        }
+        for (uint32_t c = 0; c < count; ++c)
+        {
+            m_offsets[c + 1] += m_offsets[c];
+        }
+
+        m_items.resize(bounds.size());
+        std::vector<uint32_t> cursor(m_offsets.begin(), m_offsets.end() - 1);
+
+        m_min_x.assign(count + SimdPad, Inf);
+        m_min_y.assign(count + SimdPad, Inf);
+        m_max_x.assign(count + SimdPad, -Inf);
+        m_max_y.assign(count + SimdPad, -Inf);
+
+        for (uint32_t i = 0; i < bounds.size(); ++i)
+        {
+            const Aabb &b = bounds[i];
+            const uint32_t c = chunk_of(b);
+
+            m_items[cursor[c]++] = i;
+
+            m_min_x[c] = std::min(m_min_x[c], b.min.x);
+            m_min_y[c] = std::min(m_min_y[c], b.min.y);
+            m_max_x[c] = std::max(m_max_x[c], b.max.x);
+            m_max_y[c] = std::max(m_max_y[c], b.max.y);
+        }
+    }
+
+    void SpatialGrid::query(const Aabb &view, std::vector<uint32_t> &chunks) const
+    {
+        PROFILE_SCOPE("SpatialGrid::query");
+
+        if (m_cols == 0)
+        {
+            return;
+        }
+
+        // Chunks an item can reach the view from: its own cells plus up to
+        // max_extent to the left/top.
+        const glm::vec2 first = (view.min - m_max_extent - m_origin) / m_chunk_size;
+        const glm::vec2 last = (view.max - m_origin) / m_chunk_size;
+
+        const int cx0 = std::max(0, static_cast<int>(std::floor(first.x)));
+        const int cy0 = std::max(0, static_cast<int>(std::floor(first.y)));
+        const int cx1 = std::min(m_cols - 1, static_cast<int>(std::floor(last.x)));
+        const int cy1 = std::min(m_rows - 1, static_cast<int>(std::floor(last.y)));
+
+        if (cx0 > cx1 || cy0 > cy1)
+        {
+            return;
+        }
+
+        for (int cy = cy0; cy <= cy1; ++cy)
+        {
+            test_span(static_cast<uint32_t>(cy * m_cols + cx0), static_cast<uint32_t>(cx1 - cx0 + 1), view, chunks);
+        }
+    }
+
+    void SpatialGrid::test_span(uint32_t first, uint32_t count, const Aabb &view, std::vector<uint32_t> &chunks) const
+    {
+        uint32_t i = 0;
+
+#ifdef SPATIAL_GRID_SSE
+        const __m128 view_min_x = _mm_set1_ps(view.min.x);
+        const __m128 view_min_y = _mm_set1_ps(view.min.y);
+        const __m128 view_max_x = _mm_set1_ps(view.max.x);
+        const __m128 view_max_y = _mm_set1_ps(view.max.y);
+
+        for (; i < count; i += 4)
+        {
+            const uint32_t c = first + i;
+
+            const __m128 overlap_x = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(&m_min_x[c]), view_max_x),
+                                                _mm_cmpge_ps(_mm_loadu_ps(&m_max_x[c]), view_min_x));
+            const __m128 overlap_y = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(&m_min_y[c]), view_max_y),
+                                                _mm_cmpge_ps(_mm_loadu_ps(&m_max_y[c]), view_min_y));
+
+            // Lanes past `count` belong to the next row (or padding); drop them.
+            int mask = _mm_movemask_ps(_mm_and_ps(overlap_x, overlap_y));
+            if (count - i < 4)
+            {
+                mask &= (1 << (count - i)) - 1;
+            }
+
+            for (uint32_t lane = 0; mask != 0; ++lane, mask >>= 1)
+            {
+                if (mask & 1)
+                {
+                    chunks.push_back(c + lane);
+                }
+            }
+        }
+#else
+        for (; i < count; ++i)
+        {
+            const uint32_t c = first + i;
+            if (m_min_x[c] <= view.max.x && m_max_x[c] >= view.min.x &&
+                m_min_y[c] <= view.max.y && m_max_y[c] >= view.min.y)
+            {
+                chunks.push_back(c);
+            }
+        }
+#endif
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/vec2.hpp>
+
+namespace util
+{
+    struct Aabb
+    {
+        glm::vec2 min{0.0f};
+        glm::vec2 max{0.0f};
+    };
+
+    // Uniform grid of square chunks holding item (sprite) indices.
+    //
+    // - Items are bucketed by their min corner; chunk_items() is a contiguous
+    //   slice of one index array (CSR layout), ordered by item index.
+    // - Each chunk keeps the tight bounds of its items, stored SoA so query()
+    //   tests four chunks per SSE instruction (scalar fallback without SSE).
+    // - query() only looks at the chunk rows/columns the view can touch, so
+    //   its cost follows the view size, not the world size.
+    class SpatialGrid
+    {
+    public:
+        explicit SpatialGrid(float chunk_size = 512.0f) : m_chunk_size(chunk_size) {}
+
+        // Rebuilds from scratch; bounds[i] is item i's world rect.
+        void build(std::span<const Aabb> bounds);
+
+        // Appends the IDs of non-empty chunks whose bounds intersect `view`.
+        void query(const Aabb &view, std::vector<uint32_t> &chunks) const;
+
+        std::span<const uint32_t> chunk_items(uint32_t chunk) const noexcept
+        {
+            return {m_items.data() + m_offsets[chunk], m_offsets[chunk + 1] - m_offsets[chunk]};
+        }
+
+        Aabb chunk_bounds(uint32_t chunk) const noexcept
+        {
+            return {{m_min_x[chunk], m_min_y[chunk]}, {m_max_x[chunk], m_max_y[chunk]}};
+        }
+
+        int columns() const noexcept { return m_cols; }
+        int rows() const noexcept { return m_rows; }
+        uint32_t chunk_count() const noexcept { return static_cast<uint32_t>(m_cols * m_rows); }
+        float chunk_size() const noexcept { return m_chunk_size; }
+
+    private:
+        // Appends intersecting chunks among [first, first + count).
+        void test_span(uint32_t first, uint32_t count, const Aabb &view, std::vector<uint32_t> &chunks) const;
+
+        float m_chunk_size;
+        glm::vec2 m_origin{0.0f};
+        int m_cols = 0;
+        int m_rows = 0;
+
+        // Largest item extent; items reach at most this far past their chunk.
+        glm::vec2 m_max_extent{0.0f};
+
+        std::vector<uint32_t> m_offsets; // chunk_count + 1
+        std::vector<uint32_t> m_items;
+
+        // Padded by 3 so SIMD loads past the last chunk stay in bounds;
+        // empty chunks and padding hold an inverted box that never intersects.
+        std::vector<float> m_min_x;
+        std::vector<float> m_min_y;
+        std::vector<float> m_max_x;
+        std::vector<float> m_max_y;
+    };
+}
@@ -1,7 +1,46 @@
 #include "sprite_sheet.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
 
 namespace util
 {
+    namespace
+    {
+        // Bounds of the visible texels in a w x h rect of RGBA8 pixels, as
+        // fractions of the rect; visible means alpha above the tolerance, as in
+        // classify_alpha. All zero when nothing is visible.
+        glm::vec4 visible_bounds(const unsigned char *rgba, std::size_t stride, int x, int y, int w, int h,
+                                 int tolerance = 3)
+        {
+            int x0 = w, y0 = h, x1 = -1, y1 = -1;
+
+            for (int row = 0; row < h; ++row)
+            {
+                const unsigned char *p = rgba + ((static_cast<std::size_t>(y + row) * stride) + static_cast<std::size_t>(x)) * 4;
+                for (int col = 0; col < w; ++col, p += 4)
+                {
+                    if (p[3] > tolerance)
+                    {
+                        x0 = std::min(x0, col);
+                        x1 = std::max(x1, col);
+                        y0 = std::min(y0, row);
+                        y1 = std::max(y1, row);
+                    }
+                }
+            }
+
+            if (x1 < 0)
+            {
+                return {0.0f, 0.0f, 0.0f, 0.0f};
+            }
+
+            const float fw = static_cast<float>(w);
+            const float fh = static_cast<float>(h);
+            return {x0 / fw, y0 / fh, (x1 + 1) / fw, (y1 + 1) / fh};
+        }
+    }
+
     SpriteSheet::SpriteSheet(const std::string &path, int sprite_count_x, int sprite_count_y, bool flip)
     {
         load_from_file(path, sprite_count_x, sprite_count_y, flip);
@@ -10,9 +49,12 @@ namespace util
     bool SpriteSheet::has_mask() const noexcept { return m_mask_sprite.texture.is_valid(); }
     bool SpriteSheet::has_shadow() const noexcept { return m_shadow_sprite.texture.is_valid(); }
 
-    bool SpriteSheet::load_from_file(const std::string &path, int sprite_count_x, int sprite_count_y, bool flip)
+    bool SpriteSheet::load_from_file(const std::string &path, int sprite_count_x, int sprite_count_y, bool flip,
+                                     TextureAlpha alpha)
     {
-        bool success = m_base_sprite.texture.load_from_file(path, flip);
+        PROFILE_SCOPE("SpriteSheet::load_from_file");
+
+        bool success = m_base_sprite.texture.load_from_file(path, flip, alpha);
 
         if (!success)
         {
@@ -22,20 +64,60 @@ namespace util
         m_base_sprite.sprite_width = m_base_sprite.texture.width() / sprite_count_x;
         m_base_sprite.sprite_height = m_base_sprite.texture.height() / sprite_count_y;
 
-        return validate();
+        if (!validate())
+        {
+            return false;
+        }
+
+        build_uv_table();
+        analyze_frames();
+
+        // Sprite art is minified at low zoom; distance-field atlases
+        // (Straight) must not be averaged.
+        if (alpha == TextureAlpha::Premultiplied)
+        {
+            m_base_sprite.texture.build_cell_mipmaps(m_base_sprite.sprite_width, m_base_sprite.sprite_height);
+        }
+        return true;
     }
 
     bool SpriteSheet::load_night_overlays(const std::string &mask_path,
                                           const std::string &shadow_path,
                                           bool flip)
     {
+        PROFILE_SCOPE("SpriteSheet::load_night_overlays");
+
+        bool loaded = true;
+
         // Preserved original logic exactly (even though it looks inverted).
         if (!mask_path.empty() && m_mask_sprite.texture.load_from_file(mask_path, flip))
         {
-            return false;
+            loaded = false;
+        }
+        else
+        {
+            loaded = mask_path.empty() ||
+                     m_shadow_sprite.texture.load_from_file(shadow_path, flip, TextureAlpha::Premultiplied);
         }
 
-        return mask_path.empty() || m_shadow_sprite.texture.load_from_file(shadow_path, flip);
+        // Overlays (shadows especially) reach past the base frame's texels.
+        if (has_shadow() || has_mask())
+        {
+            set_full_trims(m_frame_trim.size());
+        }
+
+        // Overlays share the base grid, possibly at another resolution.
+        for (Sprite *overlay : {&m_shadow_sprite, &m_mask_sprite})
+        {
+            const Texture &t = overlay->texture;
+            if (t.is_valid() && columns() > 0 && rows() > 0 && t.width() % columns() == 0 && t.height() % rows() == 0)
+            {
+                overlay->texture.build_cell_mipmaps(overlay->texture.width() / columns(),
+                                                    overlay->texture.height() / rows());
+            }
+        }
+
+        return loaded;
     }
 
     const Sprite &SpriteSheet::base_sprite() const noexcept { return m_base_sprite; }
@@ -94,6 +176,90 @@ namespace util
         return {u0, v0, u1, v1};
     }
 
+    void SpriteSheet::set_uv_rects(const std::vector<glm::vec4> &rects)
+    {
+        m_uv_table.upload(rects);
+        set_full_trims(rects.size());
+    }
+
+    void SpriteSheet::set_full_trims(std::size_t count)
+    {
+        m_frame_trim.assign(count, glm::vec4{0.0f, 0.0f, 1.0f, 1.0f});
+        m_trim_table.upload(m_frame_trim);
+    }
+
+    float SpriteSheet::trimmed_coverage() const noexcept
+    {
+        if (m_frame_trim.empty())
+        {
+            return 1.0f;
+        }
+
+        float area = 0.0f;
+        for (const glm::vec4 &t : m_frame_trim)
+        {
+            area += (t.z - t.x) * (t.w - t.y);
+        }
+        return area / static_cast<float>(m_frame_trim.size());
+    }
+
+    void SpriteSheet::set_array_slot(SheetArray *array, int first_layer) noexcept
+    {
+        m_array = array;
+        m_array_first_layer = first_layer;
+    }
+
+    void SpriteSheet::build_uv_table()
+    {
+        const int count = sprite_count();
+
+        std::vector<glm::vec4> rects;
+        rects.reserve(static_cast<size_t>(count));
+
+        for (int i = 0; i < count; ++i)
+        {
+            rects.push_back(uv_rect_vec4(i));
+        }
+
+        m_uv_table.upload(rects);
+        set_full_trims(rects.size());
+    }
+
+    void SpriteSheet::analyze_frames()
+    {
+        const auto pixels = m_base_sprite.texture.read_pixels();
+        const int cols = columns();
+        const int count = sprite_count();
+        const int w = m_base_sprite.sprite_width;
+        const int h = m_base_sprite.sprite_height;
+
+        m_frame_alpha.clear();
+        m_alpha_class = count > 0 ? AlphaClass::Opaque : AlphaClass::Translucent;
+
+        if (pixels.empty())
+        {
+            m_alpha_class = AlphaClass::Translucent;
+            return;
+        }
+
+        const auto stride = static_cast<size_t>(m_base_sprite.texture.width());
+
+        m_frame_alpha.reserve(static_cast<size_t>(count));
+        for (int i = 0; i < count; ++i)
+        {
+            const int x = (i % cols) * w;
+            const int y = (i / cols) * h;
+
+            const AlphaClass c = classify_alpha(pixels.data(), stride, x, y, w, h);
+            m_frame_alpha.push_back(c);
+            m_alpha_class = worst(m_alpha_class, c);
+
+            m_frame_trim[static_cast<size_t>(i)] = visible_bounds(pixels.data(), stride, x, y, w, h);
+        }
+
+        m_trim_table.upload(m_frame_trim);
+    }
+
     bool SpriteSheet::validate() const
     {
         if (m_base_sprite.texture.id() == 0 || m_base_sprite.texture.width() <= 0 || m_base_sprite.texture.height() <= 0)
@@ -1,11 +1,16 @@
 #pragma once
 
+#include "alpha_class.hpp"
 #include "texture.hpp"
+#include "uv_table.hpp"
 #include <glm/vec4.hpp>
 #include <string>
+#include <vector>
 
 namespace util
 {
+    class SheetArray;
+
     struct Sprite
     {
         Texture texture{};
@@ -18,6 +23,7 @@ namespace util
     // - loads a texture
     // - interprets it as a grid of same-sized tiles
     // - provides UV rects for a given sprite index
+    // - publishes the UV rects of every frame to the GPU (uv_table)
     class SpriteSheet
     {
     public:
@@ -27,8 +33,12 @@ namespace util
         bool has_mask() const noexcept;
         bool has_shadow() const noexcept;
 
-        bool load_from_file(const std::string &path, int sprite_count_x, int sprite_count_y, bool flip);
+        // Sprite art is color keyed and premultiplied at load (see TextureAlpha).
+        bool load_from_file(const std::string &path, int sprite_count_x, int sprite_count_y, bool flip,
+                            TextureAlpha alpha = TextureAlpha::Premultiplied);
 
+        // The shadow is premultiplied like the base; the mask is a multiply
+        // factor and is kept as authored.
         bool load_night_overlays(const std::string &mask_path,
                                  const std::string &shadow_path,
                                  bool flip);
@@ -49,12 +59,65 @@ namespace util
         glm::vec4 uv_rect_vec4(int sprite_index) const;
         glm::vec4 uv_from_grid(int col, int row, int cols, int rows) const;
 
+        // Per-frame UV rects on the GPU, indexed by the instance frame ID.
+        // Built from the grid on load; set_uv_rects replaces it for sheets whose
+        // frames are not a uniform grid (e.g. font glyphs).
+        const UvTable &uv_table() const noexcept { return m_uv_table; }
+        UvTable &uv_table() noexcept { return m_uv_table; }
+        void set_uv_rects(const std::vector<glm::vec4> &rects);
+
+        // Per-frame trim rects (x0, y0, x1, y1) as fractions of the cell: the
+        // bounds of the frame's visible texels, found at load. The renderer
+        // shrinks each quad to its rect; UVs and placement stay those of the
+        // full cell. Sheets with night overlays, and sheets whose frames are
+        // set by set_uv_rects, keep full cells.
+        const UvTable &trim_table() const noexcept { return m_trim_table; }
+        UvTable &trim_table() noexcept { return m_trim_table; }
+        const std::vector<glm::vec4> &frame_trims() const noexcept { return m_frame_trim; }
+
+        // Mean trimmed area as a fraction of the cell (1 = untrimmed); the
+        // share of fragments a quad of this sheet still shades.
+        float trimmed_coverage() const noexcept;
+
+        // Set when the sheet's cells were packed into a texture array
+        // (see util::build_sheet_arrays). Frame i lives at layer first_layer + i.
+        // The sheet's own textures may then be released; overlays are known
+        // from array()->has_shadow()/has_mask().
+        void set_array_slot(SheetArray *array, int first_layer) noexcept;
+        SheetArray *array() const noexcept { return m_array; }
+        int array_first_layer() const noexcept { return m_array_first_layer; }
+
+        // Alpha coverage of each frame, classified at load (see util::AlphaClass).
+        // Sheets not loaded from a file, or frames out of range, are Translucent.
+        AlphaClass frame_alpha(unsigned int frame) const noexcept
+        {
+            return frame < m_frame_alpha.size() ? m_frame_alpha[frame] : AlphaClass::Translucent;
+        }
+
+        // Worst class over all frames, for draws that may show any frame.
+        AlphaClass alpha_class() const noexcept { return m_alpha_class; }
+
     private:
         bool validate() const;
+        void build_uv_table();
+        void set_full_trims(std::size_t count);
+
+        // Alpha class and trim rect of every frame, from the base texture.
+        void analyze_frames();
 
     private:
         Sprite m_base_sprite;
         Sprite m_shadow_sprite;
         Sprite m_mask_sprite;
+
+        UvTable m_uv_table;
+        UvTable m_trim_table;
+        std::vector<glm::vec4> m_frame_trim;
+
+        SheetArray *m_array = nullptr;
+        int m_array_first_layer = 0;
+
+        std::vector<AlphaClass> m_frame_alpha;
+        AlphaClass m_alpha_class = AlphaClass::Translucent;
     };
 }
@@ -8,6 +8,29 @@
 
 namespace util
 {
+    namespace
+    {
+        // Color key and premultiply, once at load instead of per fragment.
+        void premultiply(unsigned char *rgba, std::size_t texels)
+        {
+            for (std::size_t i = 0; i < texels; ++i, rgba += 4)
+            {
+                // Treat near-black as transparent.
+                if (rgba[0] < 5 && rgba[1] < 5 && rgba[2] < 5)
+                {
+                    rgba[0] = rgba[1] = rgba[2] = rgba[3] = 0;
+                    continue;
+                }
+
+                const unsigned a = rgba[3];
+                for (int c = 0; c < 3; ++c)
+                {
+                    rgba[c] = static_cast<unsigned char>((rgba[c] * a + 127u) / 255u);
+                }
+            }
+        }
+    }
+
     Texture::Texture(const std::string &path, bool flip)
     {
         if (!load_from_file(path, flip))
@@ -38,15 +61,18 @@ namespace util
         m_texture_id = other.m_texture_id;
         m_width = other.m_width;
         m_height = other.m_height;
+        m_levels = other.m_levels;
+        m_internal_format = other.m_internal_format;
 
         other.m_texture_id = 0;
         other.m_width = 0;
         other.m_height = 0;
+        other.m_levels = 1;
 
         return *this;
     }
 
-    bool Texture::load_from_file(const std::string &path, bool flip)
+    bool Texture::load_from_file(const std::string &path, bool flip, TextureAlpha alpha)
     {
         release();
 
@@ -60,12 +86,19 @@ namespace util
         int width = 0;
         int height = 0;
         int channels = 0;
-        unsigned char *pixels = stbi_load(path.c_str(), &width, &height, &channels, 0);
+        const bool premultiplied = alpha == TextureAlpha::Premultiplied;
+        unsigned char *pixels = stbi_load(path.c_str(), &width, &height, &channels, premultiplied ? 4 : 0);
         if (!pixels)
         {
             return false;
         }
 
+        if (premultiplied)
+        {
+            channels = 4;
+            premultiply(pixels, static_cast<std::size_t>(width) * static_cast<std::size_t>(height));
+        }
+
         GLenum internal_format = GL_RGBA8;
         GLenum data_format = GL_RGBA;
 
@@ -119,6 +152,36 @@ namespace util
         m_texture_id = tex;
         m_width = width;
         m_height = height;
+        m_internal_format = internal_format;
+        return true;
+    }
+
+    bool Texture::create(int width, int height)
+    {
+        release();
+
+        if (width <= 0 || height <= 0)
+        {
+            return false;
+        }
+
+        GLuint tex = 0;
+        glGenTextures(1, &tex);
+        glBindTexture(GL_TEXTURE_2D, tex);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        m_texture_id = tex;
+        m_width = width;
+        m_height = height;
+        m_internal_format = GL_RGBA8;
         return true;
     }
 
@@ -142,6 +205,23 @@ namespace util
         }
         m_width = 0;
         m_height = 0;
+        m_levels = 1;
+    }
+
+    std::vector<unsigned char> Texture::read_pixels() const
+    {
+        std::vector<unsigned char> pixels(static_cast<size_t>(m_width) * static_cast<size_t>(m_height) * 4);
+        if (m_texture_id == 0 || pixels.empty())
+        {
+            return pixels;
+        }
+
+        glBindTexture(GL_TEXTURE_2D, m_texture_id);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        return pixels;
     }
 
     void Texture::set_filtering(GLenum min_filter, GLenum mag_filter)
@@ -152,4 +232,66 @@ namespace util
         glBindTexture(GL_TEXTURE_2D, 0);
     }
 
+    int Texture::build_cell_mipmaps(int cell_width, int cell_height)
+    {
+        if (m_texture_id == 0 || cell_width <= 0 || cell_height <= 0)
+        {
+            return m_levels;
+        }
+
+        std::vector<unsigned char> level = read_pixels();
+        int w = m_width;
+        int h = m_height;
+
+        glBindTexture(GL_TEXTURE_2D, m_texture_id);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        // Cells tile the texture from the origin, so while both cell edges
+        // are even every 2x2 block lies inside one cell.
+        int levels = 1;
+        while (cell_width % 2 == 0 && cell_height % 2 == 0)
+        {
+            const int nw = w / 2;
+            const int nh = h / 2;
+            std::vector<unsigned char> next(static_cast<size_t>(nw) * static_cast<size_t>(nh) * 4);
+
+            for (int y = 0; y < nh; ++y)
+            {
+                const unsigned char *row0 = level.data() + static_cast<size_t>(2 * y) * static_cast<size_t>(w) * 4;
+                const unsigned char *row1 = row0 + static_cast<size_t>(w) * 4;
+                unsigned char *dst = next.data() + static_cast<size_t>(y) * static_cast<size_t>(nw) * 4;
+
+                for (int x = 0; x < nw; ++x, dst += 4)
+                {
+                    const size_t i = static_cast<size_t>(2 * x) * 4;
+                    for (size_t c = 0; c < 4; ++c)
+                    {
+                        // Premultiplied texels average correctly as is.
+                        const unsigned sum = row0[i + c] + row0[i + 4 + c] + row1[i + c] + row1[i + 4 + c];
+                        dst[c] = static_cast<unsigned char>((sum + 2u) / 4u);
+                    }
+                }
+            }
+
+            glTexImage2D(GL_TEXTURE_2D, levels, (GLint)m_internal_format, nw, nh, 0, GL_RGBA, GL_UNSIGNED_BYTE, next.data());
+
+            level.swap(next);
+            w = nw;
+            h = nh;
+            cell_width /= 2;
+            cell_height /= 2;
+            ++levels;
+        }
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+        if (levels > 1)
+        {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        m_levels = levels;
+        return levels;
+    }
+
 }
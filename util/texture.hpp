@@ -1,10 +1,22 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include <glad/gl.h>
 
 namespace util
 {
+    // What load_from_file does to the colour channels.
+    // - Straight:      stored as authored (font distance fields, night masks)
+    // - Premultiplied: the sprite color key is applied (near-black texels
+    //                  become transparent) and rgb is multiplied by alpha;
+    //                  draw with glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA)
+    enum class TextureAlpha
+    {
+        Straight,
+        Premultiplied
+    };
+
     // Simple 2D texture wrapper.
     // Loads PNG/JPG/etc via stb_image into an OpenGL texture.
     class Texture
@@ -21,10 +33,25 @@ namespace util
         Texture(Texture &&other) noexcept;
         Texture &operator=(Texture &&other) noexcept;
 
-        bool load_from_file(const std::string &path, bool flip);
+        // Premultiplied textures are always uploaded as RGBA8.
+        bool load_from_file(const std::string &path, bool flip, TextureAlpha alpha = TextureAlpha::Straight);
+
+        // Allocates an uninitialised RGBA8 texture, e.g. as a render target.
+        bool create(int width, int height);
 
         void set_filtering(GLenum min_filter, GLenum mag_filter);
 
+        // Builds the mip chain of a grid of cell_width x cell_height cells on
+        // the CPU with a 2x2 box filter. The chain stops before a cell edge
+        // turns odd, so no level ever mixes texels of neighbouring cells.
+        // Minification becomes GL_NEAREST_MIPMAP_LINEAR: texels stay inside
+        // their cell within a level, levels are blended. Returns the level count.
+        int build_cell_mipmaps(int cell_width, int cell_height);
+        int levels() const noexcept { return m_levels; }
+
+        // Reads level 0 back as tightly packed RGBA8 (width * height * 4 bytes).
+        std::vector<unsigned char> read_pixels() const;
+
         void bind(GLuint slot = 0) const;
         void unbind() const;
 
@@ -42,5 +69,7 @@ namespace util
         GLuint m_texture_id{};
         int m_width{};
         int m_height{};
+        int m_levels = 1;
+        GLenum m_internal_format = GL_RGBA8;
     };
 }
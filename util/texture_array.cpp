@@ -0,0 +1,126 @@
+#include "texture_array.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace util
+{
+    TextureArray::~TextureArray()
+    {
+        release();
+    }
+
+    TextureArray::TextureArray(TextureArray &&other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    TextureArray &TextureArray::operator=(TextureArray &&other) noexcept
+    {
+        if (this == &other)
+        {
+            return *this;
+        }
+
+        release();
+
+        m_texture_id = std::exchange(other.m_texture_id, 0);
+        m_width = std::exchange(other.m_width, 0);
+        m_height = std::exchange(other.m_height, 0);
+        m_layers = std::exchange(other.m_layers, 0);
+        m_levels = std::exchange(other.m_levels, 1);
+
+        return *this;
+    }
+
+    bool TextureArray::create(int width, int height, int layers)
+    {
+        release();
+
+        if (width <= 0 || height <= 0 || layers <= 0)
+        {
+            return false;
+        }
+
+        glGenTextures(1, &m_texture_id);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture_id);
+
+        // Same pixel-perfect sampling as util::Texture.
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        glTexImage3D(
+            GL_TEXTURE_2D_ARRAY,
+            0,
+            GL_RGBA8,
+            width,
+            height,
+            layers,
+            0,
+            GL_RGBA,
+            GL_UNSIGNED_BYTE,
+            nullptr);
+
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        m_width = width;
+        m_height = height;
+        m_layers = layers;
+        return true;
+    }
+
+    void TextureArray::upload_layer(int layer, const unsigned char *pixels)
+    {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture_id);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        glTexSubImage3D(
+            GL_TEXTURE_2D_ARRAY,
+            0,
+            0, 0, layer,
+            m_width, m_height, 1,
+            GL_RGBA,
+            GL_UNSIGNED_BYTE,
+            pixels);
+
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    }
+
+    void TextureArray::generate_mipmaps()
+    {
+        if (m_texture_id == 0)
+        {
+            return;
+        }
+
+        m_levels = 1 + static_cast<int>(std::log2(static_cast<float>(std::max(m_width, m_height))));
+
+        glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture_id);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, m_levels - 1);
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    }
+
+    void TextureArray::bind(GLuint slot) const
+    {
+        glActiveTexture(GL_TEXTURE0 + slot);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture_id);
+    }
+
+    void TextureArray::release()
+    {
+        if (m_texture_id != 0)
+        {
+            glDeleteTextures(1, &m_texture_id);
+            m_texture_id = 0;
+        }
+        m_width = 0;
+        m_height = 0;
+        m_layers = 0;
+        m_levels = 1;
+    }
+}
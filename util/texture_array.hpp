@@ -0,0 +1,46 @@
+#pragma once
+
+#include <glad/gl.h>
+
+namespace util
+{
+    // RGBA8 GL_TEXTURE_2D_ARRAY wrapper. All layers share one width/height.
+    class TextureArray
+    {
+    public:
+        TextureArray() = default;
+        ~TextureArray();
+
+        TextureArray(const TextureArray &) = delete;
+        TextureArray &operator=(const TextureArray &) = delete;
+
+        TextureArray(TextureArray &&other) noexcept;
+        TextureArray &operator=(TextureArray &&other) noexcept;
+
+        bool create(int width, int height, int layers);
+
+        // pixels: tightly packed RGBA8, width() x height()
+        void upload_layer(int layer, const unsigned char *pixels);
+
+        // Full mip chain from level 0, after the last upload_layer. Layers are
+        // filtered independently, so cells never bleed into each other.
+        void generate_mipmaps();
+        int levels() const noexcept { return m_levels; }
+
+        void bind(GLuint slot = 0) const;
+
+        bool is_valid() const noexcept { return m_texture_id != 0; }
+        GLuint id() const noexcept { return m_texture_id; }
+        int width() const noexcept { return m_width; }
+        int height() const noexcept { return m_height; }
+        int layers() const noexcept { return m_layers; }
+        void release();
+
+    private:
+        GLuint m_texture_id{};
+        int m_width{};
+        int m_height{};
+        int m_layers{};
+        int m_levels = 1;
+    };
+}
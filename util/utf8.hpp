@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace util
+{
+    inline constexpr char32_t ReplacementChar = 0xFFFD;
+
+    // Decodes the code point starting at text[i] and advances `i` past it.
+    // Malformed input (stray continuation bytes, truncated or overlong
+    // sequences, surrogates, > U+10FFFF) yields U+FFFD and consumes one byte,
+    // so decoding always makes progress and resyncs on the next lead byte.
+    inline char32_t next_code_point(std::string_view text, size_t &i) noexcept
+    {
+        const auto byte = [&](size_t at) { return static_cast<unsigned char>(text[at]); };
+
+        const unsigned char lead = byte(i);
+        if (lead < 0x80)
+        {
+            ++i;
+            return lead;
+        }
+
+        size_t length = 0;
+        char32_t cp = 0;
+        char32_t min = 0;
+        if ((lead & 0xE0) == 0xC0)
+        {
+            length = 2, cp = lead & 0x1F, min = 0x80;
+        }
+        else if ((lead & 0xF0) == 0xE0)
+        {
+            length = 3, cp = lead & 0x0F, min = 0x800;
+        }
+        else if ((lead & 0xF8) == 0xF0)
+        {
+            length = 4, cp = lead & 0x07, min = 0x10000;
+        }
+        else
+        {
+            ++i;
+            return ReplacementChar;
+        }
+
+        if (i + length > text.size())
+        {
+            ++i;
+            return ReplacementChar;
+        }
+
+        for (size_t k = 1; k < length; ++k)
+        {
+            const unsigned char c = byte(i + k);
+            if ((c & 0xC0) != 0x80)
+            {
+                ++i;
+                return ReplacementChar;
+            }
+            cp = (cp << 6) | (c & 0x3F);
+        }
+
+        if (cp < min || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+        {
+            ++i;
+            return ReplacementChar;
+        }
+
+        i += length;
+        return cp;
+    }
+}
@@ -0,0 +1,71 @@
+#include "uv_table.hpp"
+
+#include <utility>
+
+namespace util
+{
+    UvTable::~UvTable()
+    {
+        release();
+    }
+
+    UvTable::UvTable(UvTable &&other) noexcept
+        : m_buffer(std::exchange(other.m_buffer, 0)),
+          m_texture(std::exchange(other.m_texture, 0)),
+          m_count(std::exchange(other.m_count, 0))
+    {
+    }
+
+    UvTable &UvTable::operator=(UvTable &&other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            m_buffer = std::exchange(other.m_buffer, 0);
+            m_texture = std::exchange(other.m_texture, 0);
+            m_count = std::exchange(other.m_count, 0);
+        }
+        return *this;
+    }
+
+    void UvTable::upload(const std::vector<glm::vec4> &rects)
+    {
+        if (m_buffer == 0)
+        {
+            glGenBuffers(1, &m_buffer);
+            glGenTextures(1, &m_texture);
+        }
+
+        glBindBuffer(GL_TEXTURE_BUFFER, m_buffer);
+        glBufferData(GL_TEXTURE_BUFFER, rects.size() * sizeof(glm::vec4), rects.data(), GL_STATIC_DRAW);
+
+        glBindTexture(GL_TEXTURE_BUFFER, m_texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_buffer);
+
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+        m_count = static_cast<int>(rects.size());
+    }
+
+    void UvTable::bind(GLuint slot) const
+    {
+        glActiveTexture(GL_TEXTURE0 + slot);
+        glBindTexture(GL_TEXTURE_BUFFER, m_texture);
+    }
+
+    void UvTable::release()
+    {
+        if (m_texture != 0)
+        {
+            glDeleteTextures(1, &m_texture);
+            m_texture = 0;
+        }
+        if (m_buffer != 0)
+        {
+            glDeleteBuffers(1, &m_buffer);
+            m_buffer = 0;
+        }
+        m_count = 0;
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+
+#include <glad/gl.h>
+#include <glm/vec4.hpp>
+
+namespace util
+{
+    // GPU-side table of UV rects (u0, v0, u1, v1), one per frame.
+    // Stored in a buffer texture so the vertex shader can texelFetch a rect by
+    // frame index instead of receiving UVs per instance.
+    class UvTable
+    {
+    public:
+        UvTable() = default;
+        ~UvTable();
+
+        UvTable(const UvTable &) = delete;
+        UvTable &operator=(const UvTable &) = delete;
+
+        UvTable(UvTable &&other) noexcept;
+        UvTable &operator=(UvTable &&other) noexcept;
+
+        void upload(const std::vector<glm::vec4> &rects);
+
+        void bind(GLuint slot) const;
+
+        bool is_valid() const noexcept { return m_texture != 0; }
+        GLuint id() const noexcept { return m_texture; }
+        int size() const noexcept { return m_count; }
+        void release();
+
+    private:
+        GLuint m_buffer{};
+        GLuint m_texture{};
+        int m_count{};
+    };
+}